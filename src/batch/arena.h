@@ -0,0 +1,84 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+//
+// Fixed slots for objects in one contiguous block
+//
+// Block is allocated once, objects are constructed in place and
+// destroyed again, so a slot is reused without heap allocation.
+// Slots keep alignment of T, cache line aligned objects never
+// share a line
+//
+
+template <typename T>
+class Arena
+{
+private:
+
+    struct alignas(T) Slot
+    {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t count;
+
+public:
+
+    /*
+        Allocate block of count slots
+    */
+    Arena(std::size_t count) : slots(new Slot[count]), count(count)
+    { }
+
+    Arena(const Arena &) = delete;
+    Arena & operator = (const Arena &) = delete;
+
+    /*
+        Construct object in empty slot
+    */
+    template <typename ... Args>
+    T & emplace(std::size_t index, Args && ... args)
+    {
+        return *new (slots[index].bytes) T(std::forward<Args>(args)...);
+    }
+
+    /*
+        Destroy object in slot, slot is empty again
+    */
+    void destroy(std::size_t index)
+    {
+        std::launder(reinterpret_cast<T *>(slots[index].bytes)) -> ~T();
+    }
+
+    /*
+        Returns number of slots
+    */
+    std::size_t size() const {
+        return count;
+    }
+};
+
+#endif
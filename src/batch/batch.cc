@@ -0,0 +1,147 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "batch.h"
+#include "pool.h"
+
+#include "bus/bus.h"
+#include "rom/rom.h"
+
+/*
+    Add job
+*/
+void Batch::add(Job job)
+{
+    jobs.push_back(std::move(job));
+}
+
+
+/*
+    Load and run one job on machine built in slot
+*/
+Batch::Result Batch::execute(const Job & job, Arena<Machine> & arena, std::size_t slot)
+{
+    Result result;
+
+    auto & machine = arena.emplace(slot, job.backend);
+
+    auto & bus = machine.bus;
+    auto & cpu = machine.cpu;
+
+    try
+    {
+        Rom rom(job.rom);
+        rom.attach(bus);
+        rom.boot(cpu);
+
+        if (!job.snapshot.empty()) {
+            Snapshot::load(job.snapshot).restore(cpu);
+        }
+
+        auto instructions = cpu.getInstructions();
+        auto beg = std::chrono::steady_clock::now();
+
+        result.cycles = cpu.run(job.cycles);
+
+        auto end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed = end - beg;
+
+        result.seconds      = elapsed.count();
+        result.instructions = cpu.getInstructions() - instructions;
+        result.registers    = Snapshot::read(cpu);
+        result.stats        = cpu.getStats();
+        result.summary      = Summary::read(cpu, bus, job.from, job.to, job.memory);
+    }
+    catch (const std::exception & e) 
+    {
+        result.error = e.what();
+
+        result.summary.stop  = Summary::Stop::Error;
+        result.summary.error = result.error;
+    }
+
+    arena.destroy(slot);
+    return result;
+}
+
+
+/*
+    Run all jobs on threads
+*/
+std::vector<Batch::Result> Batch::run(std::size_t threads) const
+{
+    std::vector<Result> results(jobs.size());
+
+    // One machine slot per worker, outlives pool
+    Arena<Machine> arena(std::max<std::size_t>(threads, 1));
+
+    // Each task writes only own result slot
+    {
+        Pool pool(threads);
+
+        for (std::size_t index = 0; index < jobs.size(); index++) {
+            pool.submit([this, index, &results, &arena] { results[index] = execute(jobs[index], arena, Pool::worker()); });
+        }
+    }
+
+    return results;
+}
+
+
+/*
+    Parse job list
+*/
+Batch Batch::parse(const std::string & path, uint64_t cycles, Cpu::Backend backend,
+                   uint16_t from, uint16_t to, bool memory)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("File not found " + path);
+    }
+
+    Batch batch;
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        Job job;
+
+        if (!(stream >> job.rom) || job.rom[0] == '#')
+            continue;
+
+        stream >> job.snapshot;
+
+        job.cycles  = cycles;
+        job.backend = backend;
+        job.from    = from;
+        job.to      = to;
+        job.memory  = memory;
+
+        batch.add(std::move(job));
+    }
+
+    return batch;
+}
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+#include "snapshot/snapshot.h"
+#include "stats/stats.h"
+#include "summary/summary.h"
+
+//
+// Batch runner
+//
+// Runs independent machines on a work stealing pool. Every job
+// gets own Bus, ROM mapping and Cpu, nothing is shared between
+// jobs and workers produce no output, results are returned to
+// caller in job order. Bus and Cpu of a job are built in slot of
+// its worker, so jobs don't allocate machines on heap
+//
+
+class Batch
+{
+public:
+
+    struct Job
+    {
+        /*
+            ROM image, and snapshot restored on it when not empty
+        */
+        std::string rom;
+        std::string snapshot;
+
+        uint64_t cycles = 0;
+        Cpu::Backend backend = Cpu::Backend::Table;
+
+        /*
+            Memory range of result, its bytes are kept on request
+        */
+        uint16_t from = 0x0000;
+        uint16_t to   = 0x00FF;
+        bool memory   = false;
+    };
+
+    struct Result
+    {
+        /*
+            Registers after run
+        */
+        Snapshot::Registers registers {};
+
+        /*
+            Instructions and cycles executed by this run
+        */
+        uint64_t instructions = 0;
+        uint64_t cycles = 0;
+
+        /*
+            Run time without loading
+        */
+        double seconds = 0;
+
+        /*
+            Counters of machine after run
+        */
+        Stats stats;
+
+        /*
+            Machine readable result, stop is error if job failed
+        */
+        Summary summary;
+
+        /*
+            Error message if job failed
+        */
+        std::string error;
+    };
+
+private:
+
+    //
+    // Bus and Cpu of one job in one block
+    //
+
+    struct Machine
+    {
+        Bus bus;
+        Cpu cpu;
+
+        Machine(Cpu::Backend backend) : cpu(bus, backend) 
+        { }
+    };
+
+    std::vector<Job> jobs;
+
+    /*
+        Load and run one job on machine built in slot
+    */
+    static Result execute(const Job & job, Arena<Machine> & arena, std::size_t slot);
+
+public:
+
+    /*
+        Add job
+    */
+    void add(Job job);
+
+    /*
+        Run all jobs on threads, returns results in job order
+    */
+    std::vector<Result> run(std::size_t threads) const;
+
+    /*
+        Parse job list, one "rom [snapshot]" per line
+        Empty lines and lines starting with # are skipped
+        Every job reads result of memory range from, to
+    */
+    static Batch parse(const std::string & path, uint64_t cycles, Cpu::Backend backend,
+                       uint16_t from = 0x0000, uint16_t to = 0x00FF, bool memory = false);
+};
+
+#endif
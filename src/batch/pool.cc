@@ -0,0 +1,180 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "pool.h"
+
+//
+// Index of worker running on this thread
+//
+
+static thread_local std::size_t current = 0;
+
+/*
+    Start threads
+*/
+Pool::Pool(std::size_t count)
+{
+    count = std::max<std::size_t>(count, 1);
+
+    for (std::size_t index = 0; index < count; index++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    for (std::size_t index = 0; index < count; index++) {
+        threads.emplace_back(&Pool::work, this, index);
+    }
+}
+
+
+/*
+    Finish queued tasks and join threads
+*/
+Pool::~Pool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> guard(idle);
+        running = false;
+    }
+
+    wake.notify_all();
+
+    for (auto & thread : threads) {
+        thread.join();
+    }
+}
+
+
+/*
+    Queue task
+*/
+void Pool::submit(Task task)
+{
+    auto & worker = *workers[next++ % workers.size()];
+
+    pending++;
+
+    // Counted under idle lock, so sleeping worker can't miss it,
+    // and before push, so taking it never goes below zero
+    {
+        std::lock_guard<std::mutex> guard(idle);
+        queued++;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(worker.lock);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    wake.notify_one();
+}
+
+
+/*
+    Take task from own queue front or steal from other queue back
+*/
+bool Pool::take(std::size_t index, Task & task)
+{
+    for (std::size_t offset = 0; offset < workers.size(); offset++)
+    {
+        auto & worker = *workers[(index + offset) % workers.size()];
+        std::lock_guard<std::mutex> guard(worker.lock);
+
+        if (worker.tasks.empty())
+            continue;
+
+        if (offset == 0) 
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        } 
+        else 
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+
+        queued--;
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+    Run tasks until pool is destroyed
+*/
+void Pool::work(std::size_t index)
+{
+    current = index;
+
+    while (true)
+    {
+        Task task;
+
+        if (take(index, task)) 
+        {
+            task();
+
+            if (--pending == 0) 
+            {
+                std::lock_guard<std::mutex> guard(idle);
+                done.notify_all();
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(idle);
+        wake.wait(guard, [this] { return !running || queued > 0; });
+
+        if (!running && queued == 0)
+            return;
+    }
+}
+
+
+/*
+    Block until all submitted tasks are finished
+*/
+void Pool::wait()
+{
+    std::unique_lock<std::mutex> guard(idle);
+    done.wait(guard, [this] { return pending == 0; });
+}
+
+
+/*
+    Returns number of worker threads
+*/
+std::size_t Pool::size() const
+{
+    return threads.size();
+}
+
+
+/*
+    Returns index of calling worker thread
+*/
+std::size_t Pool::worker()
+{
+    return current;
+}
@@ -0,0 +1,120 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Work stealing thread pool
+//
+// Each worker owns a task queue and takes tasks from its front.
+// Idle worker steals from the back of other queues, so long and
+// short tasks even out without a shared queue to contend on
+//
+
+class Pool
+{
+public:
+
+    using Task = std::function<void()>;
+
+private:
+
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    /*
+        Tasks waiting in queues and tasks not finished yet
+    */
+    std::atomic<std::size_t> queued  { 0 };
+    std::atomic<std::size_t> pending { 0 };
+
+    /*
+        Queue receiving next submitted task
+    */
+    std::atomic<std::size_t> next { 0 };
+
+    bool running = true;
+
+    /*
+        Guards sleeping and waiting, queued tasks wake workers
+    */
+    std::mutex idle;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    /*
+        Take task from own queue or steal from others
+    */
+    bool take(std::size_t index, Task & task);
+
+    /*
+        Worker thread
+    */
+    void work(std::size_t index);
+
+public:
+
+    /*
+        Start threads, at least one
+    */
+    Pool(std::size_t threads = std::thread::hardware_concurrency());
+
+    /*
+        Finish queued tasks and join threads
+    */
+    ~Pool();
+
+    /*
+        Queue task, queues are filled round robin
+    */
+    void submit(Task task);
+
+    /*
+        Block until all submitted tasks are finished
+    */
+    void wait();
+
+    /*
+        Returns number of worker threads
+    */
+    std::size_t size() const;
+
+    /*
+        Returns index of worker thread calling it, 
+        tasks use it to pick per-worker state
+    */
+    static std::size_t worker();
+};
+
+#endif
@@ -0,0 +1,494 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+#include "rom/rom.h"
+#include "lockstep/lockstep.h"
+
+#include "fmt/core.h"
+
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+/*
+    Benchmark workload
+
+    Program is loaded at $0400 where execution starts,
+    ROM image workloads map whole image over memory instead
+*/
+struct Workload
+{
+    std::string name;
+    std::vector<uint8_t> program;
+
+    std::string rom {};
+};
+
+/*
+    Mixes accumulator, indexed memory, read-modify-write
+    and branch instructions in an endless loop
+*/
+static const std::vector<uint8_t> mixed
+{
+    0xA2, 0x00,         // 0400: LDX #$00
+    0xA0, 0x00,         // 0402: LDY #$00
+    0x8A,               // 0404: TXA
+    0x18,               // 0405: CLC
+    0x69, 0x03,         // 0406: ADC #$03
+    0x9D, 0x00, 0x02,   // 0408: STA $0200,X
+    0x5D, 0x00, 0x03,   // 040B: EOR $0300,X
+    0x0A,               // 040E: ASL A
+    0x85, 0x10,         // 040F: STA $10
+    0xE6, 0x11,         // 0411: INC $11
+    0xE8,               // 0413: INX
+    0xD0, 0xEE,         // 0414: BNE $0404
+    0xC8,               // 0416: INY
+    0x4C, 0x04, 0x04    // 0417: JMP $0404
+};
+
+/*
+    Register only arithmetic and logic, no memory operands
+*/
+static const std::vector<uint8_t> alu
+{
+    0xA9, 0x00,         // 0400: LDA #$00
+    0x18,               // 0402: CLC
+    0x69, 0x07,         // 0403: ADC #$07
+    0x29, 0x7F,         // 0405: AND #$7F
+    0x49, 0x55,         // 0407: EOR #$55
+    0x09, 0x01,         // 0409: ORA #$01
+    0xE9, 0x03,         // 040B: SBC #$03
+    0x2A,               // 040D: ROL A
+    0x4A,               // 040E: LSR A
+    0xAA,               // 040F: TAX
+    0xE8,               // 0410: INX
+    0x8A,               // 0411: TXA
+    0xC9, 0x40,         // 0412: CMP #$40
+    0x4C, 0x02, 0x04    // 0414: JMP $0402
+};
+
+/*
+    Copies page $1000 to $2000 by absolute indexed
+    and page $2000 to $3000 by indirect indexed addressing
+*/
+static const std::vector<uint8_t> memcopy
+{
+    0xA9, 0x00,         // 0400: LDA #$00
+    0x85, 0xF0,         // 0402: STA $F0
+    0x85, 0xF2,         // 0404: STA $F2
+    0xA9, 0x20,         // 0406: LDA #$20
+    0x85, 0xF1,         // 0408: STA $F1
+    0xA9, 0x30,         // 040A: LDA #$30
+    0x85, 0xF3,         // 040C: STA $F3
+    0xA2, 0x00,         // 040E: LDX #$00
+    0xBD, 0x00, 0x10,   // 0410: LDA $1000,X
+    0x9D, 0x00, 0x20,   // 0413: STA $2000,X
+    0xE8,               // 0416: INX
+    0xD0, 0xF7,         // 0417: BNE $0410
+    0xA0, 0x00,         // 0419: LDY #$00
+    0xB1, 0xF0,         // 041B: LDA ($F0),Y
+    0x91, 0xF2,         // 041D: STA ($F2),Y
+    0xC8,               // 041F: INY
+    0xD0, 0xF9,         // 0420: BNE $041B
+    0x4C, 0x0E, 0x04    // 0422: JMP $040E
+};
+
+/*
+    Taken and not taken conditional branches on every second instruction
+*/
+static const std::vector<uint8_t> branch
+{
+    0xA2, 0x00,         // 0400: LDX #$00
+    0xA0, 0x00,         // 0402: LDY #$00
+    0x8A,               // 0404: TXA
+    0x29, 0x01,         // 0405: AND #$01
+    0xF0, 0x03,         // 0407: BEQ $040C
+    0xC8,               // 0409: INY
+    0xD0, 0x02,         // 040A: BNE $040E
+    0x88,               // 040C: DEY
+    0xEA,               // 040D: NOP
+    0x30, 0x01,         // 040E: BMI $0411
+    0xEA,               // 0410: NOP
+    0x90, 0x00,         // 0411: BCC $0413
+    0xE8,               // 0413: INX
+    0xD0, 0xEE,         // 0414: BNE $0404
+    0x4C, 0x04, 0x04    // 0416: JMP $0404
+};
+
+/*
+    Read-modify-write on zero page and absolute memory, plain and indexed
+    Undocumented combined operations are not implemented by Cpu
+*/
+static const std::vector<uint8_t> rmw
+{
+    0xA2, 0x00,         // 0400: LDX #$00
+    0xF6, 0x20,         // 0402: INC $20,X
+    0x1E, 0x00, 0x02,   // 0404: ASL $0200,X
+    0x7E, 0x00, 0x03,   // 0407: ROR $0300,X
+    0xC6, 0x30,         // 040A: DEC $30
+    0x26, 0x31,         // 040C: ROL $31
+    0x56, 0x32,         // 040E: LSR $32,X
+    0xFE, 0x00, 0x05,   // 0410: INC $0500,X
+    0xDE, 0x00, 0x06,   // 0413: DEC $0600,X
+    0xE8,               // 0416: INX
+    0xD0, 0xE9,         // 0417: BNE $0402
+    0x4C, 0x02, 0x04    // 0419: JMP $0402
+};
+
+/*
+    Measured backends
+*/
+static const std::vector<std::pair<const char *, Cpu::Backend>> backends
+{
+    { "table",  Cpu::Backend::Table  },
+    { "fused",  Cpu::Backend::Fused  },
+    { "cached", Cpu::Backend::Cached },
+    { "jit",    Cpu::Backend::Jit    }
+};
+
+/*
+    Single run of workload
+*/
+struct Sample
+{
+    uint64_t instructions;
+    uint64_t cycles;
+
+    double seconds;
+};
+
+/*
+    Median run of repetitions
+*/
+struct Result
+{
+    std::string workload;
+    std::string backend;
+
+    Sample sample;
+
+    double ips;
+    double cps;
+    double ns;
+};
+
+/*
+    Lockstep lanes against the same machines run one by one
+*/
+struct Lanes
+{
+    std::string workload;
+
+    double scalar;
+    double lockstep;
+};
+
+
+/*
+    Load workload to bus
+    Returned ROM must outlive bus use
+*/
+std::unique_ptr<Rom> load(Bus & bus, const Workload & workload)
+{
+    if (!workload.rom.empty())
+    {
+        auto rom = std::make_unique<Rom>(workload.rom);
+        rom -> attach(bus);
+
+        return rom;
+    }
+
+    std::copy(workload.program.begin(), workload.program.end(), bus.begin() + 0x0400);
+    return nullptr;
+}
+
+
+/*
+    Run workload on fresh machine
+*/
+Sample sample(const Workload & workload, Cpu::Backend backend, uint64_t cycles)
+{
+    auto bus = std::make_shared<Bus>();
+    auto rom = load(*bus, workload);
+
+    auto cpu = std::make_unique<Cpu>(bus, backend);
+    auto beg = std::chrono::steady_clock::now();
+
+    cpu -> run(cycles);
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - beg;
+
+    return { cpu -> getInstructions(), cpu -> getCycles(), elapsed.count() };
+}
+
+
+/*
+    Run workload after warmup and returns median of repetitions
+*/
+Result measure(const Workload & workload, const char * name, Cpu::Backend backend,
+               uint64_t cycles, std::size_t warmup, std::size_t repetitions)
+{
+    for (std::size_t i = 0; i < warmup; i++) {
+        sample(workload, backend, cycles);
+    }
+
+    std::vector<Sample> samples;
+
+    for (std::size_t i = 0; i < repetitions; i++) {
+        samples.push_back(sample(workload, backend, cycles));
+    }
+
+    std::sort(samples.begin(), samples.end(), [](const Sample & l, const Sample & r) {
+        return l.seconds < r.seconds;
+    });
+
+    auto & median = samples[samples.size() / 2];
+
+    return
+    {
+        workload.name,
+        name,
+        median,
+        median.instructions / median.seconds,
+        median.cycles / median.seconds,
+        median.seconds * 1e9 / median.instructions
+    };
+}
+
+
+/*
+    Run workload on all lockstep lanes and returns instructions per second
+    Scalar run is the same machines one after another on fused backend
+*/
+double measure(const Workload & workload, bool lockstep, uint64_t cycles)
+{
+    std::vector<std::unique_ptr<Rom>> roms;
+    std::vector<std::unique_ptr<Cpu>> cpus;
+    std::vector<Cpu *> lanes;
+
+    for (std::size_t lane = 0; lane < Lockstep::width; lane++)
+    {
+        auto bus = std::make_shared<Bus>();
+        roms.push_back(load(*bus, workload));
+
+        cpus.push_back(std::make_unique<Cpu>(bus, Cpu::Backend::Fused));
+        lanes.push_back(cpus.back().get());
+    }
+
+    auto beg = std::chrono::steady_clock::now();
+
+    if (lockstep)
+    {
+        Lockstep(lanes).run(cycles);
+    }
+    else
+    {
+        for (auto cpu : lanes) {
+            cpu -> run(cycles);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - beg;
+
+    uint64_t instructions = 0;
+
+    for (auto cpu : lanes) {
+        instructions += cpu -> getInstructions();
+    }
+
+    return instructions / elapsed.count();
+}
+
+
+/*
+    Print results as JSON document
+*/
+void json(const std::vector<Result> & results, const std::vector<Lanes> & lanes,
+          uint64_t cycles, std::size_t warmup, std::size_t repetitions)
+{
+    fmt::print("{{\n");
+    fmt::print("  \"cycles\": {},\n", cycles);
+    fmt::print("  \"warmup\": {},\n", warmup);
+    fmt::print("  \"repetitions\": {},\n", repetitions);
+    fmt::print("  \"results\": [\n");
+
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        auto & result = results[i];
+
+        fmt::print("    {{ \"workload\": \"{}\", \"backend\": \"{}\", \"instructions\": {}, \"cycles\": {}, "
+                   "\"seconds\": {:.6f}, \"instructions_per_second\": {:.0f}, \"cycles_per_second\": {:.0f}, "
+                   "\"ns_per_instruction\": {:.3f} }}{}\n",
+            result.workload,
+            result.backend,
+            result.sample.instructions,
+            result.sample.cycles,
+            result.sample.seconds,
+            result.ips,
+            result.cps,
+            result.ns,
+            i + 1 < results.size() ? "," : "");
+    }
+
+    fmt::print("  ],\n");
+    fmt::print("  \"lockstep\": [\n");
+
+    for (std::size_t i = 0; i < lanes.size(); i++)
+    {
+        auto & result = lanes[i];
+
+        fmt::print("    {{ \"workload\": \"{}\", \"lanes\": {}, \"scalar_instructions_per_second\": {:.0f}, "
+                   "\"lockstep_instructions_per_second\": {:.0f} }}{}\n",
+            result.workload,
+            Lockstep::width,
+            result.scalar,
+            result.lockstep,
+            i + 1 < lanes.size() ? "," : "");
+    }
+
+    fmt::print("  ]\n");
+    fmt::print("}}\n");
+}
+
+
+/*
+    Print results as table, speedup is relative to table backend
+*/
+void table(const std::vector<Result> & results, const std::vector<Lanes> & lanes)
+{
+    double base = 0;
+
+    for (auto & result : results)
+    {
+        if (result.backend == backends.front().first) {
+            base = result.ips;
+        }
+
+        fmt::print("{:<11} {:<8} {:>12.0f} instr/s {:>12.0f} cycles/s {:>7.2f} ns/instr {:>6.2f}x\n",
+            result.workload, result.backend, result.ips, result.cps, result.ns, result.ips / base);
+    }
+
+    // Lanes against the same machines run one by one
+    for (auto & result : lanes)
+    {
+        fmt::print("{:<11} {:<8} {:>12.0f} instr/s {:>6.2f}x\n", 
+            result.workload, "scalar", result.scalar, 1.0);
+
+        fmt::print("{:<11} {:<8} {:>12.0f} instr/s {:>6.2f}x\n", 
+            result.workload, "lockstep", result.lockstep, result.lockstep / result.scalar);
+    }
+}
+
+
+/*
+    Run every workload on every backend
+*/
+int main(int argc, char** argv)
+{
+    CLI::App app {"MOS 6502 interpreter benchmark"};
+
+    uint64_t cycles;
+    std::size_t warmup;
+    std::size_t repetitions;
+
+    std::string rom;
+    bool isJson;
+
+    app.add_option ("-c", cycles, "CPU cycles per run")
+        -> default_val(10000000);
+
+    app.add_option ("-w", warmup, "Warmup runs before measurement")
+        -> default_val(1);
+
+    app.add_option ("-r", repetitions, "Measured runs, median is reported")
+        -> default_val(5)
+        -> check(CLI::PositiveNumber);
+
+    app.add_option ("--rom", rom, "Functional test image, skipped when missing")
+        -> default_val("../ext/asm/bin_files/6502_functional_test.bin");
+
+    app.add_flag   ("--json", isJson, "Print results in JSON");
+
+    try {
+        app.parse(argc, argv);
+    }
+    catch(const CLI::ParseError & e) {
+        return app.exit(e);
+    }
+
+    std::vector<Workload> workloads
+    {
+        { "functional", {}, rom },
+        { "alu",        alu     },
+        { "memcopy",    memcopy },
+        { "branch",     branch  },
+        { "rmw",        rmw     },
+        { "mixed",      mixed   }
+    };
+
+    std::vector<Result> results;
+
+    for (auto & workload : workloads)
+    {
+        for (auto & [name, backend] : backends)
+        {
+            try {
+                results.push_back(measure(workload, name, backend, cycles, warmup, repetitions));
+            }
+            catch (const std::runtime_error & e)
+            {
+                // Functional test image is optional
+                fmt::print(stderr, "Skip {}: {}\n", workload.name, e.what());
+                break;
+            }
+        }
+    }
+
+    std::vector<Lanes> lanes;
+
+    for (auto & workload : workloads)
+    {
+        try {
+            lanes.push_back({ workload.name, measure(workload, false, cycles), measure(workload, true, cycles) });
+        }
+        catch (const std::runtime_error &)
+        {
+            // Skip is already reported
+        }
+    }
+
+    if (isJson)
+    {
+        json(results, lanes, cycles, warmup, repetitions);
+    }
+    else
+    {
+        table(results, lanes);
+    }
+}
@@ -15,17 +15,489 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
 #include "bus.h"
 
 #include "fmt/core.h"
+#include "fmt/format.h"
 #include "fmt/color.h"
 
-uint8_t Bus::read (uint16_t index) const {
-    return ram[index];
+/*
+    Map whole address space to internal RAM
+*/
+Bus::Bus()
+{
+    // Same as map of whole RAM, no page mirrors another
+    for (unsigned index = 0; index < pages.size(); index++)
+    {
+        auto & page = pages[index];
+
+        page.read  = page.memory   = ram.data() + (index << 8);
+        page.write = page.writable = ram.data() + (index << 8);
+    }
+}
+
+/*
+    Point page to host memory or device
+*/
+void Bus::setPage (uint8_t index, const uint8_t * read, uint8_t * write, Device * device)
+{
+    auto & page = pages[index];
+
+    // Page content changed, code decoded from it is dropped
+    uncodePage(index);
+
+    page.memory   = read;
+    page.writable = write;
+    page.device   = device;
+
+    // Watches are kept on address, not on memory
+    page.flags &= Flags::Watched;
+
+    guard(page);
+
+    frames[index].reset();
+
+    // New mirror of decoded code is marked like its other mirrors
+    for (unsigned other = 0; read != nullptr && other < pages.size(); other++)
+    {
+        if (other == index || pages[other].memory != read || !(pages[other].flags & Flags::Code))
+            continue;
+
+        for (unsigned offset = 0; offset < 0x100; offset++)
+        {
+            if (code[other << 8 | offset]) {
+                markCode((index << 8) | offset, 1);
+            }
+        }
+
+        break;
+    }
+}
+
+/*
+    Read from device or watched page
+*/
+uint8_t Bus::readSlow (uint16_t index) const
+{
+    auto & page = pages[index >> 8];
+    uint8_t data;
+
+    if (page.memory != nullptr) {
+        data = page.memory[index & 0xFF];
+    } else {
+        data = page.device -> read(index);
+        deviceReads[index >> 8]++;
+    }
+
+    if (page.flags & Flags::ReadWatched) {
+        check(index, Access::Read, data);
+    }
+
+    return data;
+}
+
+/*
+    Write to observed, watched, device or shared page, 
+    ignore write to read-only memory
+*/
+void Bus::writeSlow (uint16_t index, uint8_t data)
+{
+    auto & page = pages[index >> 8];
+
+    if (page.flags & Flags::Observed) {
+        observer(index, data);
+    }
+
+    if (page.flags & Flags::WriteWatched) {
+        check(index, Access::Write, data);
+    }
+
+    if (!poke(index, data) && page.device != nullptr) 
+    {
+        page.device -> write(index, data);
+        deviceWrites[index >> 8]++;
+    }
+}
+
+/*
+    Store byte in host memory, skip observer and watchpoints
+*/
+bool Bus::poke (uint16_t index, uint8_t data)
+{
+    auto & page = pages[index >> 8];
+
+    if (page.flags & Flags::Shared) {
+        unshare(index >> 8);
+    }
+
+    if (page.writable == nullptr)
+        return false;
+
+    page.writable[index & 0xFF] = data;
+
+    if ((page.flags & Flags::Code) && code[index]) {
+        uncode(index);
+    }
+
+    return true;
 }
 
-void Bus::write (uint16_t index, uint8_t data) {
-    ram[index] = data;
+/*
+    Copy shared frame, point page and its mirrors to copy
+    Content is same, so decoded code is kept
+*/
+void Bus::unshare (uint8_t index)
+{
+    auto shared = frames[index];
+    auto copy   = std::make_shared<Frame>(*shared);
+
+    for (unsigned other = 0; other < pages.size(); other++)
+    {
+        if (frames[other] != shared)
+            continue;
+
+        auto & page = pages[other];
+
+        page.memory   = copy -> data();
+        page.writable = copy -> data();
+        page.flags &= static_cast<uint8_t>(~Flags::Shared);
+
+        guard(page);
+
+        frames[other] = copy;
+    }
+}
+
+/*
+    Share RAM pages with snapshot
+*/
+void Bus::share (Frames & shared)
+{
+    // Host memory of pages before they are moved to frames
+    std::array<const uint8_t *, 256> host;
+
+    for (unsigned index = 0; index < pages.size(); index++) {
+        host[index] = pages[index].memory;
+    }
+
+    for (unsigned index = 0; index < pages.size(); index++)
+    {
+        auto & page = pages[index];
+        shared[index].reset();
+
+        // Only RAM is machine state
+        auto writable = page.writable != nullptr || (page.flags & Flags::Shared);
+
+        if (page.memory == nullptr || !writable)
+            continue;
+
+        if (!frames[index]) 
+        {
+            // Mirrors keep sharing one frame
+            for (unsigned other = 0; other < index && !frames[index]; other++) 
+            {
+                if (host[other] == host[index]) {
+                    frames[index] = frames[other];
+                }
+            }
+
+            if (!frames[index]) 
+            {
+                frames[index] = std::make_shared<Frame>();
+                std::copy(page.memory, page.memory + 256, frames[index] -> begin());
+            }
+
+            page.memory = frames[index] -> data();
+        }
+
+        page.writable = nullptr;
+        page.flags   |= Flags::Shared;
+
+        guard(page);
+
+        shared[index] = frames[index];
+    }
+}
+
+/*
+    Map shared frames
+*/
+void Bus::restore (const Frames & shared)
+{
+    for (unsigned index = 0; index < pages.size(); index++)
+    {
+        if (!shared[index])
+            continue;
+
+        auto & page = pages[index];
+
+        // Content changed, invalidate decoded code
+        uncodePage(index);
+
+        page.memory   = shared[index] -> data();
+        page.writable = nullptr;
+        page.device   = nullptr;
+        page.flags    = Flags::Shared | (page.flags & Flags::Watched);
+
+        guard(page);
+
+        frames[index] = shared[index];
+    }
+}
+
+/*
+    Set inline pointers of page, withdraw them while
+    page is observed or watched
+*/
+void Bus::guard (Page & page)
+{
+    if (observer) {
+        page.flags |= Flags::Observed;
+    } else {
+        page.flags &= static_cast<uint8_t>(~Flags::Observed);
+    }
+
+    page.read  = page.flags & Flags::ReadWatched ? nullptr : page.memory;
+    page.write = page.flags & (Flags::Observed | Flags::WriteWatched | Flags::Code) ? nullptr : page.writable;
+}
+
+/*
+    Send every write to observer before it is done
+*/
+void Bus::observe (Observer observer)
+{
+    this -> observer = std::move(observer);
+
+    for (auto & page : pages) {
+        guard(page);
+    }
+}
+
+/*
+    Watch access kinds on address
+*/
+void Bus::watch (uint16_t index, uint8_t access)
+{
+    if (!watches) {
+        watches = std::make_unique<uint8_t[]>(64 * 1024);
+    }
+
+    breakpoints -= (watches[index] & Access::Execute) != 0;
+    breakpoints += (access & Access::Execute) != 0;
+
+    watches[index] = access;
+
+    // Page flags are union of its addresses
+    auto & page = pages[index >> 8];
+    uint8_t flags = 0;
+
+    for (unsigned address = index & 0xFF00; address <= (index | 0x00FF); address++)
+    {
+        if (watches[address] & Access::Read)    flags |= Flags::ReadWatched;
+        if (watches[address] & Access::Write)   flags |= Flags::WriteWatched;
+        if (watches[address] & Access::Execute) flags |= Flags::Breakpoint;
+    }
+
+    page.flags = (page.flags & static_cast<uint8_t>(~Flags::Watched)) | flags;
+    guard(page);
+
+    // Code decoded from page must see new breakpoints and watches
+    uncodePage(index >> 8);
+}
+
+/*
+    Tell invalidator about writes to decoded code
+*/
+void Bus::track (Invalidator invalidator)
+{
+    this -> invalidator = std::move(invalidator);
+
+    // Marks are meaningless without invalidator
+    code.reset();
+
+    for (auto & page : pages)
+    {
+        page.flags &= static_cast<uint8_t>(~Flags::Code);
+        guard(page);
+    }
+}
+
+/*
+    Mark decoded code bytes and their mirrors
+*/
+void Bus::markCode (uint16_t index, uint16_t bytes)
+{
+    if (!code) {
+        code = std::make_unique<uint8_t[]>(64 * 1024);
+    }
+
+    for (uint16_t address = index; address != (uint16_t) (index + bytes); address++)
+    {
+        if (code[address])
+            continue;
+
+        auto memory = pages[address >> 8].memory;
+
+        // Write to any mirror changes code, all of them are marked
+        for (unsigned other = 0; other < pages.size(); other++)
+        {
+            auto & page = pages[other];
+
+            if (page.memory != memory)
+                continue;
+
+            code[(other << 8) | (address & 0xFF)] = 1;
+
+            if (!(page.flags & Flags::Code))
+            {
+                page.flags |= Flags::Code;
+                guard(page);
+            }
+        }
+    }
+}
+
+/*
+    Unmark decoded code byte and its mirrors
+*/
+void Bus::uncode (uint16_t index)
+{
+    auto memory = pages[index >> 8].memory;
+
+    for (unsigned other = 0; other < pages.size(); other++)
+    {
+        uint16_t address = (other << 8) | (index & 0xFF);
+
+        if (pages[other].memory != memory || !code[address])
+            continue;
+
+        code[address] = 0;
+
+        if (invalidator) {
+            invalidator(address);
+        }
+    }
+}
+
+/*
+    Unmark decoded code of page
+    Page keeps slow writes until code is tracked again
+*/
+void Bus::uncodePage (uint8_t index)
+{
+    if (!code || !(pages[index].flags & Flags::Code))
+        return;
+
+    for (unsigned address = index << 8u; address <= (index << 8u | 0x00FFu); address++)
+    {
+        if (code[address]) {
+            uncode(address);
+        }
+    }
+}
+
+/*
+    Returns watched access kinds of address
+*/
+uint8_t Bus::getWatch (uint16_t index) const
+{
+    return watches ? watches[index] : 0;
+}
+
+/*
+    Record hit and raise Watch in connected event word
+*/
+void Bus::signal (uint16_t index, uint8_t access, uint8_t data) const
+{
+    hit = { index, access, data };
+
+    if (events != nullptr) {
+        *events |= Watch;
+    }
+}
+
+/*
+    Returns last hit
+*/
+const Bus::Hit & Bus::getHit () const
+{
+    return hit;
+}
+
+/*
+    Returns device reads per page
+*/
+const std::array<uint64_t, 256> & Bus::getDeviceReads () const
+{
+    return deviceReads;
+}
+
+/*
+    Returns device writes per page
+*/
+const std::array<uint64_t, 256> & Bus::getDeviceWrites () const
+{
+    return deviceWrites;
+}
+
+/*
+    Map host memory, repeated every size bytes
+*/
+void Bus::map (uint8_t first, uint8_t last, uint8_t * memory, std::size_t size)
+{
+    for (unsigned index = first; index <= last; index++) 
+    {
+        auto page = memory + ((index - first) << 8) % size;
+        setPage(index, page, page, nullptr);
+    }
+}
+
+/*
+    Map read-only host memory, repeated every size bytes
+*/
+void Bus::map (uint8_t first, uint8_t last, const uint8_t * memory, std::size_t size)
+{
+    for (unsigned index = first; index <= last; index++) {
+        setPage(index, memory + ((index - first) << 8) % size, nullptr, nullptr);
+    }
+}
+
+/*
+    Attach device to pages, bus keeps device alive
+*/
+void Bus::attach (uint8_t first, uint8_t last, std::shared_ptr<Device> device)
+{
+    for (unsigned index = first; index <= last; index++) {
+        setPage(index, nullptr, nullptr, device.get());
+    }
+
+    devices.push_back(std::move(device));
+}
+
+/*
+    Connect Cpu pending event word to interrupt lines
+*/
+void Bus::connect (uint8_t * events)
+{
+    this -> events = events;
+
+    if (events != nullptr && irq) {
+        *events |= Line::Irq;
+    }
+}
+
+/*
+    Disconnect event word if it is still connected
+*/
+void Bus::disconnect (uint8_t * events)
+{
+    if (this -> events == events) {
+        this -> events = nullptr;
+    }
 }
 
 /*
@@ -34,24 +506,30 @@ void Bus::write (uint16_t index, uint8_t data) {
 */
 void Bus::printDump(uint16_t from, uint16_t to) const
 {  
+    fmt::memory_buffer buffer;
+    auto it = std::back_inserter(buffer);
+
     // Iterate memory from closest zero-nibble to 
     // last nibble supplimented to F
-    for (uint16_t x = from & ~0xF; x <= (to | 0xF); x++)
+    for (unsigned x = from & ~0xFu; x <= (to | 0xFu); x++)
     {
         // Print row label for each zero-nibble
         if ((x & 0xF) == 0x00) {
-            fmt::print(fg(fmt::color::gray), "\n{:04X}: ", x);
+            fmt::format_to(it, fg(fmt::color::gray), "\n{:04X}: ", x);
         }
 
         if (x < from || x > to) 
         {
             // Print empty space if value is out of range
-            fmt::print("{:^3}", "");
+            fmt::format_to(it, "{:^3}", "");
         } 
         else 
         {
-            auto byte = read(x);
-            fmt::print(fg(fmt::color::dark_gray), "{:02X} ", byte);
+            auto byte = peek((uint16_t) x);
+            fmt::format_to(it, fg(fmt::color::dark_gray), "{:02X} ", byte);
         }
     }
+
+    // Whole dump is written at once
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
 }
\ No newline at end of file
@@ -19,33 +19,453 @@
 #define BUS_HPP
 
 #include <array>
+#include <functional>
+#include <memory>
+#include <vector>
 #include <cstdint>
 
+#include "device.h"
+#include "scheduler.h"
+
 class Bus
 {
+public:
+
+    //
+    // Page sized block of memory owned by bus or snapshots
+    // Frame referenced by more than one owner is never written
+    //
+
+    using Frame  = std::array<uint8_t, 256>;
+    using Frames = std::array<std::shared_ptr<Frame>, 256>;
+
+    //
+    // Called with every CPU write before it is done
+    //
+
+    using Observer = std::function<void(uint16_t address, uint8_t data)>;
+
+    //
+    // Called after write to byte marked as decoded code,
+    // once for every mirror of its address
+    //
+
+    using Invalidator = std::function<void(uint16_t address)>;
+
+    //
+    // Interrupt lines
+    // Bits of Cpu pending event word raised by devices
+    //
+
+    enum Line : uint8_t
+    {
+        Irq   = 1 << 2, // Maskable, level triggered
+        Nmi   = 1 << 3, // Non-maskable, edge triggered
+        Reset = 1 << 4
+    };
+
+    //
+    // Watched access kinds of address
+    //
+
+    enum Access : uint8_t
+    {
+        Read    = 1 << 0,
+        Write   = 1 << 1,
+        Execute = 1 << 2  // PC breakpoint, checked by Cpu run loop
+    };
+
+    //
+    // Last watchpoint or breakpoint hit
+    //
+
+    struct Hit
+    {
+        uint16_t address;
+        uint8_t  access;
+
+        // Byte read or written, operation code on breakpoint
+        uint8_t  data;
+    };
+
+    //
+    // Bit of Cpu pending event word raised on hit
+    //
+
+    static const uint8_t Watch = 1 << 6;
+
 private:
     using memory = std::array<uint8_t, 64 * 1024>;
 
+    //
+    // One of 256 pages of 256 bytes
+    //
+    // Direct pages point to host memory and are accessed inline.
+    // Page without read pointer belongs to device or is watched, 
+    // page without write pointer takes slow path on write (device, 
+    // ROM, shared frame, observed, watched or holding decoded code)
+    //
+
+    enum Flags : uint8_t
+    {
+        Shared       = 1 << 0, // Frame is shared, copy it on first write
+        Observed     = 1 << 1, // Writes go to observer first
+        ReadWatched  = 1 << 2, // Some address of page has read watch
+        WriteWatched = 1 << 3, // Some address of page has write watch
+        Breakpoint   = 1 << 4, // Some address of page has breakpoint
+        Code         = 1 << 5, // Some address of page is decoded code
+
+        Watched = ReadWatched | WriteWatched | Breakpoint
+    };
+
+    // Page takes one cache line, inline access touches its first
+    // two pointers only
+    struct alignas(64) Page
+    {
+        // Inline access, nullptr takes slow path
+        const uint8_t * read = nullptr;
+        uint8_t * write      = nullptr;
+
+        // Host memory of page, kept while inline pointers are 
+        // withdrawn. Not writable for ROM and shared frame
+        const uint8_t * memory = nullptr;
+        uint8_t * writable     = nullptr;
+
+        Device * device = nullptr;
+
+        uint8_t flags = 0;
+    };
+
+    // Page table, first member so it starts at bus address
+    std::array<Page, 256> pages;
+
     // Temporary 64KB RAM
     memory ram {};
 
+    // Frames backing pages after they were shared with snapshot
+    Frames frames;
+
+    // Attached devices
+    std::vector<std::shared_ptr<Device>> devices;
+
+    // Pending event word of connected Cpu
+    uint8_t * events = nullptr;
+
+    // IRQ sources holding line low, one bit each
+    uint8_t irq = 0;
+
+    // Cycle timed events of attached devices
+    Scheduler scheduler;
+
+    // Write observer, pages are observed while it is set
+    Observer observer;
+
+    // Watched access kinds by address, allocated on first watch
+    std::unique_ptr<uint8_t[]> watches;
+
+    // Addresses with breakpoint
+    std::size_t breakpoints = 0;
+
+    // Decoded code bytes by address, allocated on first mark
+    std::unique_ptr<uint8_t[]> code;
+
+    // Told about writes to decoded code
+    Invalidator invalidator;
+
+    // Recorded by const reads
+    mutable Hit hit {};
+
+    // Device accesses per page
+    mutable std::array<uint64_t, 256> deviceReads {};
+    std::array<uint64_t, 256> deviceWrites {};
+
+    /*
+        Point page to host memory or device
+        Code decoded from page is dropped, its marks are copied
+        from pages showing same memory
+    */
+    void setPage (uint8_t index, const uint8_t * read, uint8_t * write, Device * device);
+
+    /*
+        Read from device or watched page
+    */
+    uint8_t readSlow (uint16_t index) const;
+
+    /*
+        Write to device, read-only, shared, observed or watched page
+    */
+    void writeSlow (uint16_t index, uint8_t data);
+
+    /*
+        Record hit if access of address is watched
+    */
+    void check (uint16_t index, uint8_t access, uint8_t data) const
+    {
+        if (watches[index] & access) {
+            signal(index, access, data);
+        }
+    }
+
+    /*
+        Unmark decoded code byte on address and its mirrors,
+        tell invalidator about each of them
+    */
+    void uncode (uint16_t index);
+
+    /*
+        Unmark all decoded code of page, its content changed
+    */
+    void uncodePage (uint8_t index);
+
+    /*
+        Give page and its mirrors private copy of shared frame
+    */
+    void unshare (uint8_t index);
+
+    /*
+        Set inline pointers of page from its memory, withdraw 
+        them while page is observed or watched
+    */
+    void guard (Page & page);
+
 public:
 
+    /*
+        Map whole address space to internal RAM
+    */
+    Bus();
+
     /*
         Read byte on address
     */
-    uint8_t read (uint16_t index) const;
+    uint8_t read (uint16_t index) const 
+    {
+        auto & page = pages[index >> 8];
+
+        if (page.read != nullptr) {
+            return page.read[index & 0xFF];
+        }
+
+        return readSlow(index);
+    }
+
+    /*
+        Read byte on address, watchpoints are not hit
+        and device state is left as it is
+    */
+    uint8_t peek (uint16_t index) const 
+    {
+        auto & page = pages[index >> 8];
+
+        if (page.memory != nullptr) {
+            return page.memory[index & 0xFF];
+        }
+
+        return page.device -> peek(index);
+    }
     
     /*
         Write byte on address
     */
-    void write (uint16_t index, uint8_t data);
+    void write (uint16_t index, uint8_t data) 
+    {
+        auto & page = pages[index >> 8];
+
+        if (page.write != nullptr) 
+        {
+            page.write[index & 0xFF] = data;
+            return;
+        }
+
+        writeSlow(index, data);
+    }
+
+    /*
+        Store byte in host memory, observer and watchpoints are 
+        skipped. Returns false on device or read-only page
+    */
+    bool poke (uint16_t index, uint8_t data);
+
+    /*
+        Map host memory to pages from first to last inclusive
+        Memory is repeated every size bytes, mirroring it across range
+    */
+    void map (uint8_t first, uint8_t last, uint8_t * memory, std::size_t size);
+
+    /*
+        Map read-only host memory, writes are ignored
+    */
+    void map (uint8_t first, uint8_t last, const uint8_t * memory, std::size_t size);
+
+    /*
+        Attach device to pages from first to last inclusive
+    */
+    void attach (uint8_t first, uint8_t last, std::shared_ptr<Device> device);
+
+    /*
+        Share RAM pages with snapshot, copy-on-write
+
+        Pages not backed by frame yet are copied to frames once,
+        later shares only hand out references. ROM and device pages
+        are not machine state and stay empty in shared
+    */
+    void share (Frames & shared);
+
+    /*
+        Map shared frames, copy-on-write
+        Empty frames leave their pages unchanged
+    */
+    void restore (const Frames & shared);
+
+    /*
+        Send every write to observer before it is done,
+        or stop observing with nullptr. Observed writes
+        take slow path
+    */
+    void observe (Observer observer);
+
+    /*
+        Tell invalidator about writes to decoded code,
+        nullptr stops it and unmarks all code
+    */
+    void track (Invalidator invalidator);
+
+    /*
+        Mark bytes from address as decoded code and their pages
+        as code pages. Only code pages take slow path on write
+    */
+    void markCode (uint16_t index, uint16_t bytes);
+
+    /*
+        Returns true if page with address is host memory read inline
+        Only such pages may be cached as decoded code
+    */
+    bool isDirect (uint16_t index) const {
+        return pages[index >> 8].read != nullptr;
+    }
+
+    /*
+        Returns host memory of page with address, null if page is
+        not read inline. Memory is replaced by write to shared page
+    */
+    const uint8_t * getDirect (uint16_t index) const {
+        return pages[index >> 8].read;
+    }
+
+    /*
+        Returns true if address belongs to device
+    */
+    bool isDevice (uint16_t index) const {
+        return pages[index >> 8].memory == nullptr;
+    }
+
+    /*
+        Watch access kinds on address, zero removes watch
+        Only pages with watched addresses take slow path
+    */
+    void watch (uint16_t index, uint8_t access);
+
+    /*
+        Returns watched access kinds of address
+    */
+    uint8_t getWatch (uint16_t index) const;
+
+    /*
+        Returns true if address has breakpoint
+    */
+    bool isBreakpoint (uint16_t index) const {
+        return (pages[index >> 8].flags & Flags::Breakpoint) && (watches[index] & Access::Execute);
+    }
+
+    /*
+        Returns true if any address has breakpoint
+    */
+    bool hasBreakpoints () const {
+        return breakpoints != 0;
+    }
+
+    /*
+        Record hit and raise Watch in connected event word
+    */
+    void signal (uint16_t index, uint8_t access, uint8_t data) const;
+
+    /*
+        Returns last hit
+    */
+    const Hit & getHit () const;
+
+    /*
+        Returns device reads and writes per page
+    */
+    const std::array<uint64_t, 256> & getDeviceReads () const;
+    const std::array<uint64_t, 256> & getDeviceWrites () const;
+
+    /*
+        Connect Cpu pending event word to interrupt lines
+    */
+    void connect (uint8_t * events);
+
+    /*
+        Disconnect event word if it is still connected
+    */
+    void disconnect (uint8_t * events);
+
+    /*
+        Assert or release IRQ line for source bit
+        Line stays asserted while any source holds it
+    */
+    void setIrq (uint8_t source, bool asserted)
+    {
+        irq = asserted ? (irq | source) : (irq & ~source);
+
+        if (events != nullptr) {
+            *events = irq ? (*events | Line::Irq) : (*events & ~Line::Irq);
+        }
+    }
+
+    /*
+        Returns true if any source holds IRQ line
+    */
+    bool isIrq () const {
+        return irq != 0;
+    }
+
+    /*
+        Signal NMI edge
+    */
+    void nmi () 
+    {
+        if (events != nullptr) {
+            *events |= Line::Nmi;
+        }
+    }
+
+    /*
+        Signal RESET
+    */
+    void reset ()
+    {
+        if (events != nullptr) {
+            *events |= Line::Reset;
+        }
+    }
+
+    /*
+        Returns event scheduler of attached devices
+    */
+    Scheduler & getScheduler () {
+        return scheduler;
+    }
 
     /*
         Print memory dump
     */
     void printDump (uint16_t from = 0x00, uint16_t to = 0xFF) const;
 
+    /*
+        Raw internal RAM access for loading, bypasses code tracking
+        Pages shared with snapshot no longer show internal RAM
+    */
     memory::iterator begin() {
         return ram.begin();
     }
@@ -55,4 +475,4 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+#endif
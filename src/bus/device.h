@@ -0,0 +1,53 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEVICE_HPP
+#define DEVICE_HPP
+
+#include <cstdint>
+
+//
+// Memory mapped device, i.e. PPU/APU registers or mapper
+// Attached to bus pages, receives full 16-bit address
+//
+
+class Device
+{
+public:
+
+    virtual ~Device() = default;
+
+    /*
+        Read byte on address
+    */
+    virtual uint8_t read (uint16_t address) = 0;
+
+    /*
+        Read byte on address without side effects, for debugger,
+        trace and dumps. Devices without override read zero
+    */
+    virtual uint8_t peek (uint16_t) const {
+        return 0;
+    }
+
+    /*
+        Write byte on address
+    */
+    virtual void write (uint16_t address, uint8_t data) = 0;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "scheduler.h"
+
+/*
+    Heap order, earliest entry is on top
+*/
+bool Scheduler::later(const Entry & l, const Entry & r)
+{
+    return l.cycle != r.cycle ? l.cycle > r.cycle : l.sequence > r.sequence;
+}
+
+/*
+    Connect Cpu cycle counter and pending event word
+*/
+void Scheduler::connect(const uint64_t * clock, uint8_t * events)
+{
+    this -> clock  = clock;
+    this -> events = events;
+}
+
+/*
+    Disconnect Cpu if it is still connected
+*/
+void Scheduler::disconnect(const uint64_t * clock)
+{
+    if (this -> clock == clock)
+    {
+        this -> clock  = nullptr;
+        this -> events = nullptr;
+    }
+}
+
+/*
+    Call back on cycle
+*/
+void Scheduler::schedule(uint64_t cycle, Callback callback)
+{
+    heap.push_back({ cycle, sequence++, std::move(callback) });
+    std::push_heap(heap.begin(), heap.end(), later);
+
+    // Run loop is going past event, make it return
+    if (cycle < horizon && events != nullptr) {
+        *events |= Due;
+    }
+}
+
+/*
+    Returns cycle run loop may execute up to
+*/
+uint64_t Scheduler::limit(uint64_t until)
+{
+    horizon = std::min(until, next());
+    return horizon;
+}
+
+/*
+    Call back every event due on cycle now
+*/
+void Scheduler::dispatch(uint64_t now)
+{
+    while (!heap.empty() && heap.front().cycle <= now)
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+
+        auto entry = std::move(heap.back());
+        heap.pop_back();
+
+        entry.callback(entry.cycle);
+    }
+}
+
+/*
+    Returns number of pending events
+*/
+std::size_t Scheduler::size() const
+{
+    return heap.size();
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+//
+// Cycle timed event scheduler
+//
+// Devices schedule callbacks on CPU cycle instead of being ticked
+// every cycle. Run loop executes up to the earliest event, then
+// dispatches due events in cycle order. Between events devices
+// catch up lazily from now() when bus accesses them
+//
+
+class Scheduler
+{
+public:
+
+    /*
+        Called with cycle event was scheduled on
+    */
+    using Callback = std::function<void(uint64_t cycle)>;
+
+    /*
+        Bit of Cpu pending event word raised when event is
+        scheduled before cycle run loop is going to stop at
+    */
+    static const uint8_t Due = 1 << 5;
+
+    /*
+        Cycle of empty scheduler
+    */
+    static const uint64_t never = std::numeric_limits<uint64_t>::max();
+
+private:
+
+    struct Entry
+    {
+        uint64_t cycle;
+
+        // Keeps events of same cycle in scheduling order
+        uint64_t sequence;
+
+        Callback callback;
+    };
+
+    /*
+        Min-heap on cycle and sequence
+    */
+    std::vector<Entry> heap;
+
+    uint64_t sequence = 0;
+
+    /*
+        Cycle current run loop stops at
+    */
+    uint64_t horizon = never;
+
+    /*
+        Cycle counter and pending event word of connected Cpu
+    */
+    const uint64_t * clock = nullptr;
+    uint8_t * events = nullptr;
+
+    /*
+        Heap order, earliest entry is on top
+    */
+    static bool later(const Entry & l, const Entry & r);
+
+public:
+
+    /*
+        Connect Cpu cycle counter and pending event word
+    */
+    void connect(const uint64_t * clock, uint8_t * events);
+
+    /*
+        Disconnect Cpu if it is still connected
+    */
+    void disconnect(const uint64_t * clock);
+
+    /*
+        Call back on cycle, event in past is dispatched
+        at next instruction boundary
+    */
+    void schedule(uint64_t cycle, Callback callback);
+
+    /*
+        Returns cycle run loop may execute up to, earliest
+        of until and next event. Events scheduled before it
+        make run loop return early
+    */
+    uint64_t limit(uint64_t until);
+
+    /*
+        Call back every event due on cycle now, in cycle order
+        Events scheduled by callbacks are dispatched too if due
+    */
+    void dispatch(uint64_t now);
+
+    /*
+        Returns cycle of earliest event or never
+    */
+    uint64_t next() const {
+        return heap.empty() ? never : heap.front().cycle;
+    }
+
+    /*
+        Returns cycle counter of connected Cpu
+        Counter is updated at instruction boundaries
+    */
+    uint64_t now() const {
+        return clock != nullptr ? *clock : 0;
+    }
+
+    /*
+        Returns number of pending events
+    */
+    std::size_t size() const;
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "cosim.h"
+#include "log.h"
+#include "cpu/map.h"
+
+#include "fmt/core.h"
+
+/*
+    Load ROM image on both machines, clone reference state
+*/
+Cosim::Cosim(const std::string & rom, Cpu::Backend reference, Cpu::Backend candidate, const std::string & snapshot)
+{
+    attach(this -> reference, rom, reference);
+    attach(this -> candidate, rom, candidate);
+
+    this -> reference.rom -> boot(*this -> reference.cpu);
+
+    if (!snapshot.empty()) {
+        Snapshot::load(snapshot).restore(*this -> reference.cpu);
+    }
+
+    Snapshot(*this -> reference.cpu).restore(*this -> candidate.cpu);
+}
+
+
+/*
+    Map ROM image, hash writes
+*/
+void Cosim::attach(Machine & machine, const std::string & rom, Cpu::Backend backend)
+{
+    machine.bus = std::make_shared<Bus>();
+    machine.rom = std::make_unique<Rom>(rom);
+    machine.rom -> attach(*machine.bus);
+
+    machine.cpu = std::make_unique<Cpu>(machine.bus, backend);
+
+    machine.bus -> observe([&machine](uint16_t address, uint8_t data) {
+        machine.hash = (machine.hash ^ ((uint64_t) address << 8 | data)) * 1099511628211ull;
+    });
+}
+
+
+/*
+    Remember state of both machines as last matching check
+*/
+void Cosim::save()
+{
+    for (auto machine : { &reference, &candidate })
+    {
+        machine -> checkpoint = std::make_unique<Snapshot>(*machine -> cpu);
+        machine -> checkpointHash = machine -> hash;
+    }
+}
+
+
+/*
+    Return both machines to last matching check
+*/
+void Cosim::rewind()
+{
+    for (auto machine : { &reference, &candidate })
+    {
+        machine -> checkpoint -> restore(*machine -> cpu);
+        machine -> hash = machine -> checkpointHash;
+    }
+}
+
+
+/*
+    Returns true if registers, status and write hashes match
+*/
+bool Cosim::matches() const
+{
+    auto l = Snapshot::read(*reference.cpu);
+    auto r = Snapshot::read(*candidate.cpu);
+
+    return l.cycles == r.cycles && l.instructions == r.instructions
+        && l.pc == r.pc && l.a == r.a && l.x == r.x && l.y == r.y && l.s == r.s && l.p == r.p
+        && reference.hash == candidate.hash;
+}
+
+
+/*
+    Step from last matching check to first diverging instruction
+*/
+bool Cosim::locate(uint64_t until)
+{
+    auto & l = *reference.cpu;
+    auto & r = *candidate.cpu;
+
+    while (l.getCycles() < until)
+    {
+        auto pc = l.getPc();
+        auto opcode = reference.bus -> peek(pc);
+
+        auto other = r.getPc();
+        auto code  = candidate.bus -> peek(other);
+
+        // Single instruction on each backend
+        l.run(1);
+        r.run(1);
+
+        // Both halted by JAM at the same state, nothing left to step
+        if (matches() && l.isHalted())
+            break;
+
+        if (matches())
+            continue;
+
+        fmt::print("Diverged at instruction {}{}\n", l.counter, 
+            reference.hash != candidate.hash ? ", memory writes differ" : "");
+
+        // Machines are not traced, report has own disassemblers
+        fmt::print("reference ");
+        Log(*reference.bus).step(l.counter, pc, Map::getCommand(opcode), &l);
+
+        fmt::print("candidate ");
+        Log(*candidate.bus).step(r.counter, other, Map::getCommand(code), &r);
+
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+    Run both machines, comparing every interval cycles
+*/
+bool Cosim::run(uint64_t budget, uint64_t interval)
+{
+    auto until = reference.cpu -> getCycles() + budget;
+
+    save();
+
+    while (reference.cpu -> getCycles() < until)
+    {
+        auto cycles = std::min(interval, until - reference.cpu -> getCycles());
+
+        reference.cpu -> run(cycles);
+        candidate.cpu -> run(cycles);
+
+        if (!matches())
+        {
+            auto diverged = reference.cpu -> getCycles();
+
+            rewind();
+
+            auto matched = reference.cpu -> getCycles();
+
+            if (!locate(diverged))
+            {
+                fmt::print("Diverged between cycles {} and {}, single steps do not reproduce it\n",
+                    matched, diverged);
+            }
+
+            return false;
+        }
+
+        save();
+        checks++;
+
+        // Matching machines are both halted by JAM
+        if (reference.cpu -> isHalted())
+            break;
+    }
+
+    return true;
+}
+
+
+/*
+    Returns number of passed checks
+*/
+uint64_t Cosim::getChecks() const
+{
+    return checks;
+}
+
+
+/*
+    Returns reference machine
+*/
+const Cpu & Cosim::getReference() const
+{
+    return *reference.cpu;
+}
@@ -0,0 +1,119 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COSIM_H
+#define COSIM_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+#include "rom/rom.h"
+#include "snapshot/snapshot.h"
+
+//
+// Differential co-simulation
+//
+// Runs candidate backend next to reference backend on cloned
+// machine state. Registers, status and rolling hash of all
+// memory writes are compared once per interval. On mismatch
+// both machines go back to last matching check and step one
+// instruction at a time to find the first diverging one
+//
+
+class Cosim
+{
+private:
+
+    struct Machine
+    {
+        std::shared_ptr<Bus> bus;
+        std::unique_ptr<Rom> rom;
+        std::unique_ptr<Cpu> cpu;
+
+        // FNV-1a of written addresses and values
+        uint64_t hash = 14695981039346656037ull;
+
+        // Last matching check
+        std::unique_ptr<Snapshot> checkpoint;
+        uint64_t checkpointHash = 0;
+    };
+
+    Machine reference;
+    Machine candidate;
+
+    /*
+        Checks passed
+    */
+    uint64_t checks = 0;
+
+    /*
+        Map ROM image, hash writes
+    */
+    void attach(Machine & machine, const std::string & rom, Cpu::Backend backend);
+
+    /*
+        Remember state of both machines as last matching check
+    */
+    void save();
+
+    /*
+        Return both machines to last matching check
+    */
+    void rewind();
+
+    /*
+        Returns true if registers, status and write hashes match
+    */
+    bool matches() const;
+
+    /*
+        Step from last matching check up to cycle until, print first 
+        diverging instruction of both machines. Returns false if single
+        steps do not reproduce divergence
+    */
+    bool locate(uint64_t until);
+
+public:
+
+    /*
+        Load ROM image on both machines, candidate state is cloned
+        from reference after optional snapshot is restored
+    */
+    Cosim(const std::string & rom, Cpu::Backend reference, Cpu::Backend candidate,
+          const std::string & snapshot = "");
+
+    /*
+        Run both machines for cycle budget, comparing every interval cycles
+        Returns false and prints report on divergence
+    */
+    bool run(uint64_t budget, uint64_t interval);
+
+    /*
+        Returns number of passed checks
+    */
+    uint64_t getChecks() const;
+
+    /*
+        Returns reference machine
+    */
+    const Cpu & getReference() const;
+};
+
+#endif
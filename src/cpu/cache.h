@@ -0,0 +1,146 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdint>
+#include <memory>
+
+#include "bus/bus.h"
+
+//
+// Decode cache
+//
+// One predecoded instruction per program counter. Decoded bytes are
+// marked as code on the bus, and write to any of them drops entries
+// which may contain it, including self-modifying code. Writes to
+// other bytes of the same page keep entries. Device pages are never
+// cached
+//
+
+class Cache
+{
+public:
+
+    struct Entry
+    {
+        /*
+            Operand bytes following operation code (lo | hi << 8)
+        */
+        uint16_t operand = 0;
+
+        uint8_t opcode = 0;
+
+        /*
+            Entry was decoded and its bytes are unchanged since
+        */
+        bool valid = false;
+    };
+
+private:
+
+    /*
+        Entries for whole 64KB address space
+    */
+    std::unique_ptr<Entry[]> entries;
+
+    /*
+        Bus holding cached code
+    */
+    Bus & bus;
+
+    uint64_t lookups       = 0;
+    uint64_t misses        = 0;
+    uint64_t invalidations = 0;
+
+public:
+
+    /*
+        Tracks decoded code on bus until Cpu stops tracking it
+    */
+    Cache(Bus & bus) : 
+        entries(std::make_unique<Entry[]>(64 * 1024)), 
+        bus(bus)
+    { 
+        bus.track([this](uint16_t address) { invalidate(address); });
+    }
+
+    /*
+        Returns entry for program counter
+    */
+    Entry & at(uint16_t pc) 
+    {
+        lookups++;
+        return entries[pc];
+    }
+
+    /*
+        Returns true if code at program counter may be cached
+    */
+    bool cacheable(uint16_t pc) const {
+        return bus.isDirect(pc);
+    }
+
+    /*
+        Mark entry decoded from bytes at program counter
+    */
+    void insert(Entry & entry, uint16_t pc, uint8_t bytes) 
+    {
+        entry.valid = true;
+        bus.markCode(pc, bytes);
+    }
+
+    /*
+        Drop entries of instructions which may contain address
+        Instruction is at most three bytes long
+    */
+    void invalidate(uint16_t address)
+    {
+        for (uint16_t pc = address - 2; pc != (uint16_t) (address + 1); pc++) 
+        {
+            auto & entry = entries[pc];
+
+            invalidations += entry.valid;
+            entry.valid = false;
+        }
+    }
+
+    /*
+        Count entry which is not decoded
+    */
+    void miss() {
+        misses++;
+    }
+
+    /*
+        Returns number of lookups, misses and invalidated entries
+    */
+    uint64_t getLookups() const {
+        return lookups;
+    }
+
+    uint64_t getMisses() const {
+        return misses;
+    }
+
+    uint64_t getInvalidations() const {
+        return invalidations;
+    }
+};
+
+#endif
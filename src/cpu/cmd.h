@@ -19,19 +19,19 @@
 #define CMD_HPP
 
 #include <cstdint>
-#include <string>
+#include <type_traits>
 
 #include "cpu.h"
 
+//
+// Opcode descriptor
+// Execution data only, names live in Map
+//
+
 class Cmd
 {
 public:
 
-    /*
-        Command name (BRK, ORA etc)
-    */
-    std::string name;
-
     /*
         Programm cycles need to execute command
     */
@@ -43,6 +43,12 @@ public:
     void (Cpu::*code) (void);
     void (Cpu::*mode) (void);
 
+    /*
+        Extra cycle when indexed operand crosses page boundary
+        Set only for reading commands in ABSX, ABSY, INDY modes
+    */
+    uint8_t penalty = 0;
+
 
     /*
         Execute command
@@ -63,30 +69,46 @@ public:
     /*
         Command is Accumulator adressing
     */
-    bool isAcc() const {
+    constexpr bool isAcc() const {
         return mode == &Cpu::ACC;
-    };
+    }
 
     /*
         Command is relation adressing
     */
-    bool isRel() const {
+    constexpr bool isRel() const {
         return mode == &Cpu::REL;
     }
 
+    /*
+        Command may move program counter to non sequential address
+    */
+    constexpr bool isJump() const
+    {
+        return isRel() 
+            || code == &Cpu::JMP 
+            || code == &Cpu::JSR 
+            || code == &Cpu::RTS 
+            || code == &Cpu::RTI 
+            || code == &Cpu::BRK
+            || code == &Cpu::JAM;
+    }
+
     /*
         Command length in bytes
     */
-    uint8_t getBytes() const
+    constexpr uint8_t getBytes() const
     {
         if (isAcc() || mode == &Cpu::IMP)
             return 1;
 
-        if (mode == &Cpu::ABS || mode == &Cpu::ABSX || mode == &Cpu::ABSY)
+        if (mode == &Cpu::ABS || mode == &Cpu::ABSX || mode == &Cpu::ABSY || mode == &Cpu::IND || mode == &Cpu::IAX)
             return 3;
 
         return 2;
     }
 };
 
+static_assert(std::is_trivially_copyable_v<Cmd>, "Cmd must stay trivially copyable");
+
 #endif
\ No newline at end of file
@@ -15,44 +15,79 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <array>
+
 #include "log.h"
 #include "cmd.h"
 
 #include "cpu/cpu.h"
 #include "cpu/map.h"
 #include "cpu/mem.h"
+#include "cpu/variant.h"
 #include "bus/bus.h"
+#include "trace/trace.h"
+#include "trace/recorder.h"
+#include "profile/profile.h"
 
 
 /*
     Default constructor
 */
 
-Cpu::Cpu(std::shared_ptr<Bus> bus)
+Cpu::Cpu(std::shared_ptr<Bus> bus, Backend backend) : Cpu(*bus, backend)
+{
+    owner = std::move(bus);
+}
+
+
+/*
+    Construct on bus owned by caller
+*/
+
+Cpu::Cpu(Bus & bus, Backend backend) : backend(backend), mem(bus)
 {
-    map = std::make_unique<Map>();
-    log = std::make_unique<Log>(bus);
-    mem = std::make_unique<Mem>(bus);
+    // Decode cache is allocated only when used
+    if (backend == Backend::Cached) {
+        cache = std::make_unique<Cache>(bus);
+    }
+
+    if (backend == Backend::Jit) {
+        jit = std::make_unique<Jit>(bus);
+    }
+
+    bus.connect(&events);
+    bus.getScheduler().connect(&cycles, &events);
 }
 
 
 /*
-    Default destructor
+    Disconnect from interrupt lines and decoded code
 */
 
-Cpu::~Cpu() = default;
+Cpu::~Cpu()
+{
+    // Bus may outlive cache, its code must not be tracked by it
+    if (cache || jit) {
+        mem.getBus().track(nullptr);
+    }
+
+    mem.getBus().disconnect(&events);
+    mem.getBus().getScheduler().disconnect(&cycles);
+}
 
 
 /*
     Read data from memory/accumulator
 */
 
+template <Cpu::Operand operand>
 uint8_t Cpu::read() const
 {
-    if (cmd -> isAcc())
+    if constexpr (operand == Accumulator)
         return a;
 
-    return mem -> read(op);
+    return mem.read(op);
 }
 
 
@@ -60,54 +95,847 @@ uint8_t Cpu::read() const
     Write data to memory or accumulator 
 */
 
+template <Cpu::Operand operand>
 void Cpu::write (uint8_t data)
 {
-    if (cmd -> isAcc()) {
+    if constexpr (operand == Accumulator) {
         a = data;
     } else {
-        mem -> write(op, data);
+        mem.write(op, data);
+    }
+}
+
+
+/*
+    Read operation code and execute command
+    on compile time selected backend
+*/
+
+template <Cpu::Backend backend>
+uint8_t Cpu::execute ()
+{
+    counter++;
+
+    uint8_t code;
+
+    // Execute command
+    if constexpr (backend == Backend::Cached) {
+        code = decoded();
+    } else {
+        code = mem.read(pc++);
+
+        if constexpr (backend == Backend::Fused) {
+            dispatch(code);
+        } else {
+            Map::getCommand(code).execute(this);
+        }
+    }
+
+    auto & oper = Map::getCommand(code);
+
+    // Base cycles plus page boundary penalty
+    cycles += oper.cycles + (cross & oper.penalty);
+
+    return code;
+}
+
+
+/*
+    Read operation code and execute command
+    on backend selected at construction
+*/
+
+uint8_t Cpu::step ()
+{
+    switch (backend)
+    {
+        case Backend::Fused:  return execute<Backend::Fused>();
+        case Backend::Cached: return execute<Backend::Cached>();
+
+        // Single steps are never translated
+        case Backend::Jit:    return execute<Backend::Fused>();
+        default:              return execute<Backend::Table>();
+    }
+}
+
+
+/*
+    Execute single instruction with disassembled output
+*/
+
+void Cpu::clock ()
+{
+    poll();
+
+    auto temp = pc;
+    auto code = step();
+
+    if (trace) {
+        print(temp, code);
+    }
+}
+
+
+/*
+    Batched execution loop
+    No per-instruction calls besides the command itself
+*/
+
+template <Cpu::Backend backend, Cpu::Probe probe>
+void Cpu::loop (uint64_t until)
+{
+    while (cycles < until && !events)
+    {
+        // Translated blocks end before breakpoints,
+        // checking block entry is enough for them
+        if constexpr (probe != Probe::None) 
+        {
+            if (breakpoint())
+                break;
+        }
+
+        if constexpr (probe == Probe::Profiled)
+        {
+            auto temp  = pc;
+            auto start = cycles;
+
+            // Host time is taken around sampled instructions only
+            uint8_t code;
+
+            if (profile -> sampling())
+            {
+                auto ticks = Profile::ticks();
+                code = execute<backend>();
+
+                profile -> time(code, Profile::ticks() - ticks);
+            }
+            else
+            {
+                code = execute<backend>();
+            }
+
+            profile -> count(temp, code, cycles - start, pc);
+
+            if (trace) {
+                print(temp, code);
+            }
+        }
+        else if constexpr (probe == Probe::Traced) 
+        {
+            auto temp = pc;
+            auto code = execute<backend>();
+
+            print(temp, code);
+        } 
+        else if constexpr (backend == Backend::Jit)
+        {
+            if (!translated(until)) {
+                execute<Backend::Fused>();
+            }
+        }
+        else 
+        {
+            execute<backend>();
+        }
+    }
+}
+
+
+/*
+    Select profiled, traced, breakpoint or plain loop for backend
+*/
+
+template <Cpu::Backend backend>
+void Cpu::loop (uint64_t until)
+{
+    if (!trace && !profile) 
+    {
+        if (mem.getBus().hasBreakpoints()) {
+            loop<backend, Probe::Break>(until);
+        } else {
+            loop<backend, Probe::None>(until);
+        }
+
+        return;
+    }
+
+    // Translated blocks are not traced or profiled
+    constexpr auto base = backend == Backend::Jit ? Backend::Fused : backend;
+
+    if (profile) {
+        loop<base, Probe::Profiled>(until);
+    } else {
+        loop<base, Probe::Traced>(until);
+    }
+}
+
+
+/*
+    Execute instructions until cycle budget is exhausted
+    or an event is pending
+*/
+
+uint64_t Cpu::run (uint64_t budget)
+{
+    auto start = cycles;
+    auto until = start + std::min(budget, std::numeric_limits<uint64_t>::max() - start);
+
+    auto & scheduler = mem.getBus().getScheduler();
+
+    // Continue from breakpoint or watchpoint
+    events &= ~Event::Break;
+
+    // Loop runs up to next device event and leaves on any pending
+    // event, device events and interrupts are handled here
+    do
+    {
+        auto stop = scheduler.limit(until);
+
+        switch (backend)
+        {
+            case Backend::Fused:  loop<Backend::Fused>(stop);  break;
+            case Backend::Cached: loop<Backend::Cached>(stop); break;
+            case Backend::Jit:    loop<Backend::Jit>(stop);    break;
+            default:              loop<Backend::Table>(stop);  break;
+        }
+
+        scheduler.dispatch(cycles);
+    } 
+    while (cycles < until && service());
+
+    events &= ~Event::Stop;
+    return cycles - start;
+}
+
+
+/*
+    Push program counter and status, jump to vector
+    Pushed status has Break flag clear
+*/
+
+void Cpu::interrupt (uint16_t vector)
+{
+    mem.push(s, (pc & 0xFF00) >> 8);
+    mem.push(s, (pc & 0x00FF));
+    mem.push(s, p & ~0x10);
+
+    p.setInterrupt(true);
+
+    // 65C02 leaves decimal mode on interrupt
+    if constexpr (Variant::cmos) {
+        p.setDecimal(false);
+    }
+
+    pc  = mem.read(vector);
+    pc |= mem.read(vector + 1) << 8;
+
+    cycles += 7;
+    interrupts++;
+}
+
+
+/*
+    Handle pending interrupts
+
+    NMI takes precedence over IRQ. IRQ is dropped from events
+    both when serviced and when masked, unmask() raises it again
+*/
+
+bool Cpu::service ()
+{
+    // Loop stop cycle is taken again from scheduler
+    events &= ~Event::Due;
+
+    if (events & Event::Reset) 
+    {
+        events &= ~(Event::Reset | Event::Halt);
+        reset();
+    }
+
+    // Halted CPU does not take interrupts
+    if (events & Event::Halt) 
+    {
+        events &= ~(Event::Nmi | Event::Irq);
+        return false;
+    }
+
+    if (events & Event::Nmi) 
+    {
+        events &= ~Event::Nmi;
+        interrupt(0xFFFA);
+    }
+    else if (events & Event::Irq) 
+    {
+        events &= ~Event::Irq;
+
+        if (!p.getInterrupt()) {
+            interrupt(0xFFFE);
+        }
+    }
+
+    return !(events & (Event::Stop | Event::Trap | Event::Break | Event::Halt));
+}
+
+
+/*
+    Dispatch due device events and service pending interrupts
+    Used between single steps, run() does it per loop instead
+*/
+
+bool Cpu::poll ()
+{
+    auto & scheduler = mem.getBus().getScheduler();
+
+    if (cycles >= scheduler.next()) {
+        scheduler.dispatch(cycles);
+    }
+
+    return !events || service();
+}
+
+
+/*
+    Raise Break if program counter has breakpoint
+    Instruction run was resumed on is executed
+*/
+
+bool Cpu::breakpoint ()
+{
+    auto & bus = mem.getBus();
+
+    if (!bus.isBreakpoint(pc) || counter == resumed)
+        return false;
+
+    resumed = counter;
+    bus.signal(pc, Bus::Access::Execute, bus.peek(pc));
+
+    return true;
+}
+
+
+/*
+    Raise IRQ again if line is still held after I flag is cleared
+*/
+
+void Cpu::unmask ()
+{
+    if (!p.getInterrupt() && mem.getBus().isIrq()) {
+        events |= Event::Irq;
+    }
+}
+
+
+/*
+    Pass instruction to disassembler if trace accepts it
+*/
+
+void Cpu::print (uint16_t pc, uint8_t opcode) const
+{
+    if (!trace -> accept(counter, pc, opcode))
+        return;
+
+    if (recorder == nullptr) 
+    {
+        log -> step(counter, pc, Map::getCommand(opcode), this);
+        return;
+    }
+
+    auto & bus = mem.getBus();
+    auto size  = Map::getCommand(opcode).getBytes();
+
+    Record record {};
+
+    record.cycle   = cycles;
+    record.pc      = pc;
+    record.opcode  = opcode;
+
+    for (int i = 1; i < size; i++) {
+        record.args[i - 1] = bus.peek(pc + i);
+    }
+
+    record.a       = a;
+    record.x       = x;
+    record.y       = y;
+    record.s       = s;
+    record.p       = p;
+
+    recorder -> push(record);
+}
+
+
+/*
+    Send traced instructions to binary recorder
+*/
+
+void Cpu::setRecorder (Recorder * recorder)
+{
+    this -> recorder = recorder;
+}
+
+
+/*
+    Enable tracing with filter or disable it with nullptr
+*/
+
+void Cpu::setTrace (std::unique_ptr<Trace> trace)
+{
+    this -> trace = std::move(trace);
+
+    if (this -> trace && !log) {
+        log = std::make_unique<Log>(mem.getBus());
+    }
+}
+
+
+/*
+    Count executed instructions in profiler or disable it with nullptr
+*/
+
+void Cpu::setProfile (Profile * profile)
+{
+    this -> profile = profile;
+}
+
+
+/*
+    Make run loop return at next instruction boundary
+*/
+
+void Cpu::stop ()
+{
+    events |= Event::Stop;
+}
+
+
+/*
+    Stop run loop for good at jump or branch to itself
+*/
+
+void Cpu::setTrapDetection (bool enabled)
+{
+    trapping = enabled ? Event::Trap : 0;
+    events &= ~Event::Trap;
+}
+
+
+/*
+    Returns true if run loop was stopped by trap
+*/
+
+bool Cpu::isTrapped () const
+{
+    return events & Event::Trap;
+}
+
+
+/*
+    Returns true if run loop was stopped by breakpoint or watchpoint
+*/
+
+bool Cpu::isBreak () const
+{
+    return events & Event::Break;
+}
+
+
+/*
+    Returns true if CPU is halted by JAM until reset
+*/
+
+bool Cpu::isHalted () const
+{
+    return events & Event::Halt;
+}
+
+
+/*
+    Returns program counter
+*/
+
+uint16_t Cpu::getPc () const
+{
+    return pc;
+}
+
+
+/*
+    Returns total instructions executed
+*/
+
+uint64_t Cpu::getInstructions () const
+{
+    return counter;
+}
+
+
+/*
+    Returns total programm cycles executed
+*/
+
+uint64_t Cpu::getCycles () const
+{
+    return cycles;
+}
+
+
+/*
+    Returns counters of CPU, its memory, decode caches and bus devices
+*/
+
+Stats Cpu::getStats () const
+{
+    Stats stats;
+
+    stats.instructions = counter;
+    stats.cycles       = cycles;
+    stats.interrupts   = interrupts;
+    stats.pushes       = mem.getPushes();
+    stats.pops         = mem.getPops();
+
+    if (cache)
+    {
+        stats.cacheLookups       = cache -> getLookups();
+        stats.cacheMisses        = cache -> getMisses();
+        stats.cacheInvalidations = cache -> getInvalidations();
+    }
+
+    if (jit)
+    {
+        stats.blockLookups = jit -> getLookups();
+        stats.blockHits    = jit -> getHits();
+        stats.translations = jit -> getTranslations();
+        stats.blockDrops   = jit -> getDrops();
     }
+
+    auto & bus = mem.getBus();
+
+    stats.deviceReads  = bus.getDeviceReads();
+    stats.deviceWrites = bus.getDeviceWrites();
+
+    return stats;
 }
 
 
-/*
-    Read operation code and execute command
-    Returns total programm cycles per operation
-*/
+/*
+    Fused handler
+
+    Addressing mode and command are taken from the constexpr
+    opcode table, so both calls are bound at compile time
+    and can be inlined into the handler
+*/
+
+template <uint8_t opcode>
+void Cpu::fused ()
+{
+    constexpr auto & oper = Map::getCommand(opcode);
+
+    (this->*oper.mode)();
+    (this->*oper.code)();
+}
+
+
+/*
+    Predecoded handler
+
+    Same as fused handler, but operand bytes come from decode
+    cache instead of memory. Effective address is computed here
+    for the addressing mode known at compile time. Declared inline
+    so predecode switch holds handler bodies instead of calls
+*/
+
+template <uint8_t opcode>
+inline void Cpu::predecoded (uint16_t operand)
+{
+    constexpr auto & oper  = Map::getCommand(opcode);
+    constexpr auto   bytes = oper.getBytes();
+
+    auto start = pc;
+    pc += bytes;
+
+    if constexpr (oper.mode == &Cpu::IMM || oper.mode == &Cpu::REL) {
+        op = start + 1;
+    } 
+    else if constexpr (oper.mode == &Cpu::ABS) {
+        op = operand;
+    } 
+    else if constexpr (oper.mode == &Cpu::ABSX || oper.mode == &Cpu::ABSY) 
+    {
+        op = operand + (oper.mode == &Cpu::ABSX ? x : y);
+        cross = Mem::crossed(operand, op);
+    } 
+    else if constexpr (oper.mode == &Cpu::ZPG) {
+        op = operand;
+    } 
+    else if constexpr (oper.mode == &Cpu::ZPGX || oper.mode == &Cpu::ZPGY) {
+        op = 0x00FF & (operand + (oper.mode == &Cpu::ZPGX ? x : y));
+    } 
+    else if constexpr (oper.mode == &Cpu::ACC) {
+        op = a;
+    } 
+    else if constexpr (oper.mode == &Cpu::IND) {
+        op = mem.pointer(operand);
+    } 
+    else if constexpr (oper.mode == &Cpu::IAX) 
+    {
+        uint16_t index = operand + x;
+        op = mem.direct(index);
+    } 
+    else if constexpr (oper.mode == &Cpu::ZPI) 
+    {
+        uint16_t lo = mem.read(operand);
+        uint16_t hi = mem.read(0x00FF & (operand + 1));
+
+        op = (hi << 8) | lo;
+    } 
+    else if constexpr (oper.mode == &Cpu::INDX) 
+    {
+        uint16_t lo = mem.read(0x00FF & (operand + x));
+        uint16_t hi = mem.read(0x00FF & (operand + x + 1));
+
+        op = (hi << 8) | lo;
+    } 
+    else if constexpr (oper.mode == &Cpu::INDY) 
+    {
+        uint16_t lo = mem.read(operand);
+        uint16_t hi = mem.read(0x00FF & (operand + 1));
+        uint16_t index = (hi << 8) | lo;
+
+        op = index + y;
+        cross = Mem::crossed(index, op);
+    }
+
+    (this->*oper.code)();
+}
+
+
+/*
+    Fetch instruction from decode cache
+    Decodes it again if its bytes were written since last decode
+*/
+
+uint8_t Cpu::decoded ()
+{
+    auto & entry = cache -> at(pc);
+
+    if (!entry.valid) 
+    {
+        cache -> miss();
+
+        // Instructions on device pages are not cached
+        if (!decode(entry)) 
+        {
+            auto code = mem.read(pc++);
+            dispatch(code);
+            
+            return code;
+        }
+    }
+
+    predecode(entry.opcode, entry.operand);
+    return entry.opcode;
+}
+
+
+/*
+    Decode instruction at program counter into cache entry
+    Returns false if any instruction byte is on device page
+*/
+
+bool Cpu::decode (Cache::Entry & entry)
+{
+    if (!cache -> cacheable(pc))
+        return false;
+
+    auto code  = mem.read(pc);
+    auto bytes = Map::getCommand(code).getBytes();
+
+    if (!cache -> cacheable(pc + bytes - 1))
+        return false;
+
+    entry.opcode  = code;
+    entry.operand = 0;
+
+    if (bytes > 1) entry.operand |= mem.read(pc + 1);
+    if (bytes > 2) entry.operand |= mem.read(pc + 2) << 8;
+
+    cache -> insert(entry, pc, bytes);
+
+    return true;
+}
+
+
+/*
+    Generates one switch case per opcode
+*/
+
+#define OPCODE_ROW(CASE, n)                                        \
+    CASE(n + 0x0) CASE(n + 0x1) CASE(n + 0x2) CASE(n + 0x3)        \
+    CASE(n + 0x4) CASE(n + 0x5) CASE(n + 0x6) CASE(n + 0x7)        \
+    CASE(n + 0x8) CASE(n + 0x9) CASE(n + 0xA) CASE(n + 0xB)        \
+    CASE(n + 0xC) CASE(n + 0xD) CASE(n + 0xE) CASE(n + 0xF)
+
+#define OPCODE_CASES(CASE)                                         \
+    OPCODE_ROW(CASE, 0x00) OPCODE_ROW(CASE, 0x10)                  \
+    OPCODE_ROW(CASE, 0x20) OPCODE_ROW(CASE, 0x30)                  \
+    OPCODE_ROW(CASE, 0x40) OPCODE_ROW(CASE, 0x50)                  \
+    OPCODE_ROW(CASE, 0x60) OPCODE_ROW(CASE, 0x70)                  \
+    OPCODE_ROW(CASE, 0x80) OPCODE_ROW(CASE, 0x90)                  \
+    OPCODE_ROW(CASE, 0xA0) OPCODE_ROW(CASE, 0xB0)                  \
+    OPCODE_ROW(CASE, 0xC0) OPCODE_ROW(CASE, 0xD0)                  \
+    OPCODE_ROW(CASE, 0xE0) OPCODE_ROW(CASE, 0xF0)
+
+#define FUSED(n)      case (n): fused<(n)>(); break;
+#define PREDECODED(n) case (n): predecoded<(n)>(operand); break;
+
+
+/*
+    Execute opcode through fused handlers
+*/
+
+void Cpu::dispatch (uint8_t opcode)
+{
+    switch (opcode)
+    {
+        OPCODE_CASES(FUSED)
+    }
+}
+
+
+/*
+    Execute opcode through predecoded handlers
+*/
+
+void Cpu::predecode (uint8_t opcode, uint16_t operand)
+{
+    switch (opcode)
+    {
+        OPCODE_CASES(PREDECODED)
+    }
+}
+
+/*
+    Execute translated block at program counter
+    Block is translated once its start address is hot, following
+    translated blocks are chained without returning to run loop
+*/
+
+bool Cpu::translated (uint64_t until)
+{
+    auto block = jit -> find(pc);
+
+    if (block == nullptr) 
+    {
+        if (!jit -> hot(pc)) 
+            return false;
+
+        if ((block = translate()) == nullptr)
+            return false;
+    }
+
+    do
+    {
+        for (auto & instruction : block -> code)
+        {
+            counter++;
+
+            (this->*instruction.handler)(instruction.operand);
+
+            // Base cycles plus page boundary penalty
+            cycles += instruction.cycles + (cross & instruction.penalty);
+
+            // Leave on budget, pending event or write to block code
+            if (cycles >= until || events || block -> stale)
+                return true;
+        }
+    }
+    while ((block = jit -> find(pc)) != nullptr && !block -> breakpoint);
+
+    return true;
+}
+
+
+/*
+    Translate instructions from program counter up to jump,
+    page end or block size limit
+*/
+
+#define HANDLER(n) &Cpu::predecoded<(n)>,
+
+Jit::Block * Cpu::translate ()
+{
+    static constexpr Jit::Handler handlers[] = { OPCODE_CASES(HANDLER) };
+
+    if (!jit -> cacheable(pc))
+        return nullptr;
+
+    auto block = std::make_unique<Jit::Block>();
+    auto address = pc;
+
+    auto & bus = mem.getBus();
+
+    // Run loop checks breakpoint before entering block
+    block -> breakpoint = bus.isBreakpoint(pc);
+
+    while (block -> code.size() < Jit::limit)
+    {
+        // Breakpoint starts its own block
+        if (address != pc && bus.isBreakpoint(address))
+            break;
+
+        auto code  = mem.read(address);
+        auto bytes = Map::getCommand(code).getBytes();
+
+        // Block stays on its page
+        if ((address & 0x00FF) + bytes > 0x0100) 
+            break;
 
-void Cpu::clock ()
-{
-    counter++;
+        auto & oper = Map::getCommand(code);
+        uint16_t operand = 0;
 
-    auto temp = pc;
+        if (bytes > 1) operand |= mem.read(address + 1);
+        if (bytes > 2) operand |= mem.read(address + 2) << 8;
+
+        block -> code.push_back({ handlers[code], operand, code, oper.cycles, oper.penalty });
+        address += bytes;
 
-    auto code = mem -> read(pc++);  
-    auto oper = map -> getCommand(code);
+        if (oper.isJump() || Mem::crossed(pc, address))
+            break;
+    }
 
-    cmd = &oper;
+    if (block -> code.empty())
+        return nullptr;
 
-    // Execute command and returns programm cycles
-    oper.execute(this);
+    block -> bytes = address - pc;
 
-    // Disassembled output
-    if (counter > 26764002)
-        log -> step(counter, temp, oper, this);
+    return jit -> insert(pc, std::move(block));
 }
 
+#undef HANDLER
+#undef PREDECODED
+#undef FUSED
+#undef OPCODE_CASES
+#undef OPCODE_ROW
+
 
 /*
-    Reset CPU and clear all registers & flags
+    Reset CPU, clear registers and load program counter
+    from RESET vector
 */
 
 void Cpu::reset ()
 {
     x = 0x00;
     y = 0x00;
-    p = 0x00;
-    s = 0x00;
     a = 0x00;
 
-    pc = 0x0000;
+    // Reset sequence does three dummy pushes
+    s = 0xFD;
+
+    p = 0x00;
+    p.setInterrupt(true);
+
+    pc  = mem.read(0xFFFC);
+    pc |= mem.read(0xFFFD) << 8;
 }
 
 
@@ -143,7 +971,7 @@ void Cpu::ABS ()
     // OPC $LLHH	
     // Operand is address $HHLL
 
-    op = mem -> abs(pc);
+    op = mem.abs(pc);
 }
 
 
@@ -168,7 +996,7 @@ void Cpu::ABSX ()
     // Operand is address; 
     // Effective address is address incremented by X with carry
 
-    op = mem -> abs(pc, x);
+    op = mem.abs(pc, x, cross);
 }
 
 
@@ -178,7 +1006,7 @@ void Cpu::ABSY ()
     // Operand is address; 
     // Effective address is address incremented by Y with carry
 
-    op = mem -> abs(pc, y);
+    op = mem.abs(pc, y, cross);
 }
 
 
@@ -197,7 +1025,7 @@ void Cpu::ZPG ()
     // OPC $LL
     // Operand is zeropage address (hi-byte is zero, address = $00LL)
 
-    op = mem -> zpg(pc);
+    op = mem.zpg(pc);
 }
 
 
@@ -221,7 +1049,7 @@ void Cpu::ZPGX ()
     // Operand is zeropage address; 
     // Effective address is address incremented by X without carry
 
-    op = mem -> zpg(pc, x);
+    op = mem.zpg(pc, x);
 }
 
 
@@ -231,7 +1059,7 @@ void Cpu::ZPGY ()
     // Operand is zeropage address; 
     // Effective address is address incremented by Y without carry
 
-    op = mem -> zpg(pc, y);
+    op = mem.zpg(pc, y);
 }
 
 
@@ -284,7 +1112,7 @@ void Cpu::IND ()
     // Operand is address; 
     // Effective address is contents of word at address: C.w($HHLL)
 
-    op = mem -> indirect(pc);
+    op = mem.indirect(pc);
 }
 
 
@@ -305,7 +1133,7 @@ void Cpu::INDX ()
     // Operand is zeropage address; 
     // Effective address is word in (LL + X, LL + X + 1), inc. without carry: C.w($00LL + X)
 
-    op = mem -> indexed(pc, x);
+    op = mem.indexed(pc, x);
 }
 
 
@@ -328,7 +1156,7 @@ void Cpu::INDY ()
     // Operand is zeropage address; 
     // Effective address is word in (LL, LL + 1) incremented by Y with carry: C.w($00LL) + Y
 
-    op = mem -> indexed(pc) + y;
+    op = mem.indexed(pc, y, cross);
 }
 
 
@@ -350,6 +1178,46 @@ void Cpu::REL ()
 }
 
 
+/* 
+    Zero Page Indirect Addressing [(ZPG)], 65C02
+
+    Same as Indirect, Y without index: the second byte of the
+    instruction points to a memory location in page zero which
+    contains the low-order byte of the effective address, the
+    next page zero location contains the high-order byte.
+*/
+
+void Cpu::ZPI () 
+{ 
+    // OPC ($LL)
+    // Operand is zeropage address; 
+    // Effective address is word in (LL, LL + 1): C.w($00LL)
+
+    op = mem.indexed(pc);
+}
+
+
+/* 
+    Absolute Indexed Indirect Addressing [(ABS, X)], 65C02
+    (Jump Instruction Only)
+
+    The X register is added to the address in the second and
+    third bytes of the instruction. The result points to the
+    low-order byte of the effective address, the next memory
+    location contains the high-order byte.
+*/
+
+void Cpu::IAX () 
+{ 
+    // OPC ($LLHH,X)
+    // Operand is address; 
+    // Effective address is word at address incremented by X: C.w($HHLL + X)
+
+    auto index = mem.abs(pc, x);
+    op = mem.direct(index);
+}
+
+
 /*
     Add Arg to Accumulator with Carry
 */
@@ -365,6 +1233,145 @@ void Cpu::ADC (uint8_t arg)
     a = 0x00FF & sum;
 }
 
+
+/*
+    Decimal mode tables
+
+    Digits are adjusted in two steps, low digit first: index of
+    low table is binary sum (difference) of low digits with carry,
+    index of high table is binary sum (difference) of high digits
+    with adjusted low digit. Unused on variants without decimal mode
+*/
+
+/*
+    Adjusted low digit of sum, 0x10 carries to high digit
+*/
+static constexpr auto addLow = [] 
+{
+    std::array<uint8_t, 32> table {};
+
+    for (unsigned sum = 0; sum < table.size(); sum++) {
+        table[sum] = sum >= 0x0A ? ((sum + 0x06) & 0x0F) + 0x10 : sum;
+    }
+
+    return table;
+}();
+
+/*
+    Accumulator in low byte and Carry in high byte of adjusted sum
+*/
+static constexpr auto addHigh = [] 
+{
+    std::array<uint16_t, 512> table {};
+
+    for (unsigned sum = 0; sum < table.size(); sum++) 
+    {
+        auto adjusted = sum >= 0xA0 ? sum + 0x60 : sum;
+        table[sum] = (0x00FF & adjusted) | (adjusted >= 0x100 ? 0x0100 : 0);
+    }
+
+    return table;
+}();
+
+/*
+    Adjusted low digit of difference, index is offset by 16,
+    -0x10 borrows from high digit
+*/
+static constexpr auto subLow = [] 
+{
+    std::array<int8_t, 32> table {};
+
+    for (int difference = -16; difference < 16; difference++) {
+        table[difference + 16] = difference < 0 ? ((difference - 0x06) & 0x0F) - 0x10 : difference;
+    }
+
+    return table;
+}();
+
+/*
+    Accumulator of adjusted difference, index is offset by 256
+*/
+static constexpr auto subHigh = [] 
+{
+    std::array<uint8_t, 512> table {};
+
+    for (int difference = -256; difference < 256; difference++) {
+        table[difference + 256] = 0x00FF & (difference < 0 ? difference - 0x60 : difference);
+    }
+
+    return table;
+}();
+
+
+/*
+    Add Arg to Accumulator with Carry in decimal mode
+
+    Zero flag is set by binary sum, Negative and Overflow by sum 
+    before high digit is adjusted. 65C02 sets Negative and Zero
+    by result and takes one more cycle
+*/
+void Cpu::ADCD (uint8_t arg)
+{
+    uint16_t low = addLow [(a & 0x0F) + (arg & 0x0F) + p.getCarry()];
+    uint16_t sum = (a & 0xF0) + (arg & 0xF0) + low;
+
+    auto adjusted = addHigh [sum];
+
+    p.setNegative ((uint8_t) sum);
+    p.setZero     ((uint8_t) (a + arg + p.getCarry()));
+    p.setCarry    ((bool) (adjusted >> 8));
+    p.setOverflow ((bool) (~(a ^ arg) & (a ^ sum) & 0x80));
+
+    a = 0x00FF & adjusted;
+
+    if constexpr (Variant::cmos) 
+    {
+        p.setNegative (a);
+        p.setZero     (a);
+
+        cycles++;
+    }
+}
+
+
+/*
+    Subtract Arg from Accumulator with Borrow in decimal mode
+
+    Flags are set by binary difference. 65C02 adjusts binary
+    difference instead of digits, sets Negative and Zero by 
+    result and takes one more cycle
+*/
+void Cpu::SBCD (uint8_t arg)
+{
+    uint8_t adjusted;
+
+    if constexpr (Variant::cmos) 
+    {
+        int low = (a & 0x0F) - (arg & 0x0F) + p.getCarry() - 1;
+        int difference = a - arg + p.getCarry() - 1;
+
+        adjusted = 0x00FF & (difference - (difference < 0 ? 0x60 : 0) - (low < 0 ? 0x06 : 0));
+    } 
+    else
+    {
+        int low = subLow [(a & 0x0F) - (arg & 0x0F) + p.getCarry() - 1 + 16];
+        int difference = (a & 0xF0) - (arg & 0xF0) + low;
+
+        adjusted = subHigh [difference + 256];
+    }
+
+    ADC (~arg);
+    a = adjusted;
+
+    if constexpr (Variant::cmos) 
+    {
+        p.setNegative (a);
+        p.setZero     (a);
+
+        cycles++;
+    }
+}
+
 /*
     ADC
     Add Memory to Accumulator with Carry
@@ -387,6 +1394,11 @@ void Cpu::ADC (uint8_t arg)
 void Cpu::ADC() 
 { 
     auto data = read();
+
+    if constexpr (Variant::decimal) {
+        if (p.isDecimal()) return ADCD(data);
+    }
+
     ADC(data); 
 }
 
@@ -520,18 +1532,22 @@ void Cpu::ARR()
     | absolute,X  | ASL oper,X | 1E  | 3     | 7      |
     +-------------+------------+-----+-------+--------+
 */
+template <Cpu::Operand operand>
 void Cpu::ASL() 
 {
-    uint8_t data  = read();
+    uint8_t data  = read<operand>();
     uint8_t shift = data << 1;
 
     p.setNegative (shift);
     p.setZero     (shift);
     p.setCarry    ((bool) (data & 0x80));
 
-    write(shift);
+    write<operand>(shift);
 }
 
+template void Cpu::ASL<Cpu::Memory>();
+template void Cpu::ASL<Cpu::Accumulator>();
+
 
 /*
     Branch 
@@ -543,7 +1559,16 @@ void Cpu::ASL()
 */
 void Cpu::BRA()
 {
+    auto from = pc;
     pc += (int8_t) read();
+
+    // Branch taken, plus one more cycle to other page
+    cycles += 1 + Mem::crossed(from, pc);
+
+    // Branch to itself is never left
+    if (pc == (uint16_t) (from - 2)) {
+        events |= trapping;
+    }
 }
 
 
@@ -610,6 +1635,26 @@ void Cpu::BEQ()
 }
 
 
+/*
+    BIT (65C02)
+    Test Bits in Immediate with Accumulator
+
+    Immediate BIT sets zero-flag only.
+
+    A AND M                               N Z C I D V
+                                          - + - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | immediate  | BIT #oper | 89  | 2     | 2      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::BIM() 
+{
+    p.setZero (read() & a);
+}
+
+
 /*
     BIT
     Test Bits in Memory with Accumulator
@@ -730,16 +1775,20 @@ void Cpu::BRK()
     uint8_t hi = (pc & 0xFF00) >> 8;
 
     // Push program counter
-    mem -> push(s, hi);
-    mem -> push(s, lo);
+    mem.push(s, hi);
+    mem.push(s, lo);
     
     // Push status register
-    mem -> push(s, p);
+    mem.push(s, p);
 
-    pc  = mem -> read(0xFFFE);
-    pc |= mem -> read(0xFFFF) << 8;
+    pc  = mem.read(0xFFFE);
+    pc |= mem.read(0xFFFF) << 8;
 
     p.setInterrupt (true);
+
+    if constexpr (Variant::cmos) {
+        p.setDecimal (false);
+    }
 }
 
 
@@ -836,6 +1885,7 @@ void Cpu::CLD()
 void Cpu::CLI() 
 { 
     p.setInterrupt(false);
+    unmask();
 }
 
 
@@ -963,6 +2013,27 @@ void Cpu::DCP()
 }
 
 
+/*
+    DEC A (65C02)
+    Decrement Accumulator by One
+
+    A - 1 -> A                            N Z C I D V
+                                          + + - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | accumulator| DEC A     | 3A  | 1     | 2      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::DEA() 
+{ 
+    a--;
+
+    p.setNegative (a);
+    p.setZero     (a);
+}
+
+
 /*
     DEC
     Decrement Memory by One
@@ -1061,6 +2132,27 @@ void Cpu::EOR()
 }
 
 
+/*
+    INC A (65C02)
+    Increment Accumulator by One
+
+    A + 1 -> A                            N Z C I D V
+                                          + + - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | accumulator| INC A     | 1A  | 1     | 2      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::INA() 
+{ 
+    a++;
+
+    p.setNegative (a);
+    p.setZero     (a);
+}
+
+
 /*
     INC
     Increment Memory by One
@@ -1166,7 +2258,9 @@ void Cpu::ISC()
 */
 void Cpu::JAM() 
 { 
-    NOP();
+    // Program counter stays at operation code
+    pc--;
+    events |= Event::Halt;
 }
 
 
@@ -1186,6 +2280,11 @@ void Cpu::JAM()
 */
 void Cpu::JMP() 
 { 
+    // Jump to itself is never left
+    if (op == (uint16_t) (pc - 3)) {
+        events |= trapping;
+    }
+
     pc = op;
 }
 
@@ -1211,10 +2310,11 @@ void Cpu::JSR()
     uint8_t lo = (0x00FF & pc);
     uint8_t hi = (0xFF00 & pc) >> 8; 
 
-    mem -> push(s, hi);
-    mem -> push(s, lo);
+    mem.push(s, hi);
+    mem.push(s, lo);
 
-    JMP();
+    // Set target directly, JMP self-check would see the decremented pc
+    pc = op;
 }
 
 
@@ -1353,18 +2453,22 @@ void Cpu::LDY()
     | absolute,X  | LSR oper,X | 5E  | 3     | 7      |
     +-------------+------------+-----+-------+--------+
 */
+template <Cpu::Operand operand>
 void Cpu::LSR() 
 { 
-    uint8_t data  = read();
+    uint8_t data  = read<operand>();
     uint8_t shift = data >> 1; 
 
     p.setNegative (shift);
     p.setZero     (shift);
     p.setCarry    ((bool) (data & 0x01));
 
-    write (shift);
+    write<operand> (shift);
 }
 
+template void Cpu::LSR<Cpu::Memory>();
+template void Cpu::LSR<Cpu::Accumulator>();
+
 
 /*
     LXA (LAX immediate)
@@ -1442,7 +2546,7 @@ void Cpu::ORA()
 */
 void Cpu::PHA() 
 { 
-    mem -> push(s, a);
+    mem.push(s, a);
 }
 
 
@@ -1463,12 +2567,48 @@ void Cpu::PHA()
 */
 void Cpu::PHP() 
 { 
-    mem -> push(s, p);
+    mem.push(s, p);
 
     p.setBreak(false);
 }
 
 
+/*
+    PHX (65C02)
+    Push Index X on Stack
+
+    push X                                N Z C I D V
+                                          - - - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | implied    | PHX       | DA  | 1     | 3      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::PHX() 
+{ 
+    mem.push(s, x);
+}
+
+
+/*
+    PHY (65C02)
+    Push Index Y on Stack
+
+    push Y                                N Z C I D V
+                                          - - - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | implied    | PHY       | 5A  | 1     | 3      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::PHY() 
+{ 
+    mem.push(s, y);
+}
+
+
 /*
     PLA
     Pull Accumulator from Stack
@@ -1483,7 +2623,7 @@ void Cpu::PHP()
 */
 void Cpu::PLA() 
 { 
-    a = mem -> pop(s);
+    a = mem.pop(s);
 
     p.setNegative (a);
     p.setZero     (a);
@@ -1507,7 +2647,50 @@ void Cpu::PLA()
 */
 void Cpu::PLP() 
 { 
-    p = mem -> pop(s);
+    p = mem.pop(s);
+    unmask();
+}
+
+
+/*
+    PLX (65C02)
+    Pull Index X from Stack
+
+    pull X                                N Z C I D V
+                                          + + - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | implied    | PLX       | FA  | 1     | 4      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::PLX() 
+{ 
+    x = mem.pop(s);
+
+    p.setNegative (x);
+    p.setZero     (x);
+}
+
+
+/*
+    PLY (65C02)
+    Pull Index Y from Stack
+
+    pull Y                                N Z C I D V
+                                          + + - - - -
+    +------------+-----------+-----+-------+--------+
+    | addressing | assembler | opc | bytes | cycles |
+    +------------+-----------+-----+-------+--------+
+    | implied    | PLY       | 7A  | 1     | 4      |
+    +------------+-----------+-----+-------+--------+
+*/
+void Cpu::PLY() 
+{ 
+    y = mem.pop(s);
+
+    p.setNegative (y);
+    p.setZero     (y);
 }
 
 
@@ -1551,18 +2734,22 @@ void Cpu::RLA()
     | absolute,X  | ROL oper,X | 3E  | 3     | 7      |
     +-------------+------------+-----+-------+--------+
 */
+template <Cpu::Operand operand>
 void Cpu::ROL() 
 { 
-    uint8_t data  = read();
+    uint8_t data  = read<operand>();
     uint8_t shift = (data << 1) | p.getCarry();
 
     p.setNegative (shift);
     p.setZero     (shift);
     p.setCarry    ((bool) (data & 0x80));
 
-    write (shift);
+    write<operand> (shift);
 }
 
+template void Cpu::ROL<Cpu::Memory>();
+template void Cpu::ROL<Cpu::Accumulator>();
+
 
 /*
     ROR
@@ -1580,18 +2767,22 @@ void Cpu::ROL()
     | absolute,X  | ROR oper,X | 7E  | 3     | 7      |
     +-------------+------------+-----+-------+--------+
 */
+template <Cpu::Operand operand>
 void Cpu::ROR() 
 { 
-    uint8_t data  = read();
+    uint8_t data  = read<operand>();
     uint8_t shift = (data >> 1) | (p.getCarry() << 7);
 
     p.setNegative (shift);
     p.setZero     (shift);
     p.setCarry    ((bool) (data & 0x01));
 
-    write (shift);
+    write<operand> (shift);
 }
 
+template void Cpu::ROR<Cpu::Memory>();
+template void Cpu::ROR<Cpu::Accumulator>();
+
 
 /*
     RRA
@@ -1636,12 +2827,13 @@ void Cpu::RRA()
 */
 void Cpu::RTI() 
 { 
-    p   = mem -> pop(s); 
+    p   = mem.pop(s); 
 
-    pc  = mem -> pop(s);
-    pc |= mem -> pop(s) << 8;
+    pc  = mem.pop(s);
+    pc |= mem.pop(s) << 8;
 
     p.setBreak(false);
+    unmask();
 }
 
 
@@ -1659,8 +2851,8 @@ void Cpu::RTI()
 */
 void Cpu::RTS() 
 { 
-    pc  = mem -> pop(s);
-    pc |= mem -> pop(s) << 8;
+    pc  = mem.pop(s);
+    pc |= mem.pop(s) << 8;
 
     pc++;   
 }
@@ -1710,6 +2902,11 @@ void Cpu::SAX()
 void Cpu::SBC() 
 { 
     auto data = read();
+
+    if constexpr (Variant::decimal) {
+        if (p.isDecimal()) return SBCD(data);
+    }
+
     ADC(~data); 
 }
 
@@ -1965,6 +3162,27 @@ void Cpu::STY()
 }
 
 
+/*
+    STZ (65C02)
+    Store Zero in Memory
+
+    0 -> M                                N Z C I D V
+                                          - - - - - -
+    +------------+------------+-----+-------+--------+
+    | addressing | assembler  | opc | bytes | cycles |
+    +------------+------------+-----+-------+--------+
+    | zeropage   | STZ oper   | 64  | 2     | 3      |
+    | zeropage,X | STZ oper,X | 74  | 2     | 4      |
+    | absolute   | STZ oper   | 9C  | 3     | 4      |
+    | absolute,X | STZ oper,X | 9E  | 3     | 5      |
+    +------------+------------+-----+-------+--------+
+*/
+void Cpu::STZ() 
+{ 
+    write(0x00);
+}
+
+
 /*
     TAS (XAS, SHS)
     Puts A AND X in SP and stores A AND X AND 
@@ -2030,6 +3248,50 @@ void Cpu::TAY()
 }
 
 
+/*
+    TRB (65C02)
+    Test and Reset Memory Bits with Accumulator
+
+    A AND M, M AND (NOT A) -> M           N Z C I D V
+                                          - + - - - -
+    +------------+------------+-----+-------+--------+
+    | addressing | assembler  | opc | bytes | cycles |
+    +------------+------------+-----+-------+--------+
+    | zeropage   | TRB oper   | 14  | 2     | 5      |
+    | absolute   | TRB oper   | 1C  | 3     | 6      |
+    +------------+------------+-----+-------+--------+
+*/
+void Cpu::TRB() 
+{ 
+    auto data = read();
+
+    p.setZero (data & a);
+    write(data & ~a);
+}
+
+
+/*
+    TSB (65C02)
+    Test and Set Memory Bits with Accumulator
+
+    A AND M, M OR A -> M                  N Z C I D V
+                                          - + - - - -
+    +------------+------------+-----+-------+--------+
+    | addressing | assembler  | opc | bytes | cycles |
+    +------------+------------+-----+-------+--------+
+    | zeropage   | TSB oper   | 04  | 2     | 5      |
+    | absolute   | TSB oper   | 0C  | 3     | 6      |
+    +------------+------------+-----+-------+--------+
+*/
+void Cpu::TSB() 
+{ 
+    auto data = read();
+
+    p.setZero (data & a);
+    write(data | a);
+}
+
+
 /*
     TSX
     Transfer Stack Pointer to Index X
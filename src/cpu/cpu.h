@@ -21,29 +21,65 @@
 #include <memory>
 #include <array>
 #include <cstdint>
+#include <limits>
 #include <string>
 
+#include "bus/bus.h"
+#include "stats/stats.h"
+
+#include "mem.h"
 #include "status.h"
+#include "cache.h"
+#include "jit.h"
 
 class Cmd;
 class Log;
 class Map;
-class Mem;
-class Bus;
+class Trace;
+class Recorder;
+class Profile;
 
 //
 // MOS Technology 6502
 //
 
-class Cpu
+class alignas(64) Cpu
 {
+public:
+
+    //
+    // Interpreter backends
+    //
+
+    enum class Backend : uint8_t
+    {
+        Table,  // Addressing mode and command called through Cmd member pointers
+        Fused,  // Opcode switch over handlers fused at compile time
+        Cached, // Fused handlers fed from predecoded instruction cache
+        Jit     // Hot blocks translated to threaded code, fused handlers otherwise
+    };
+
 private:
 
     friend class Cmd;
     friend class Log;
     friend class Map;
+    friend class Snapshot;
+    friend class Lockstep;
+    friend class Cosim;
+    friend class Rewind;
 
 private:
+
+    //
+    // Hot state
+    //
+    // Registers, pending events, cycle counters and memory are laid out
+    // in the first cache line of Cpu, which is cache line aligned. Run
+    // loop of table and fused backends touches nothing else, decode
+    // cache and translated blocks start the second line
+    //
+
     //
     // A    Accumulator
     //
@@ -104,6 +140,52 @@ private:
 
     Status p {};
 
+    //
+    // Pending events, checked once per instruction by
+    // the run loop and make it return when non-zero
+    //
+
+    enum Event : uint8_t
+    {
+        Stop  = 1 << 0, // Host requested loop exit
+        Trap  = 1 << 1, // Jump or branch to itself, stays set
+
+        // Interrupt lines raised through bus, serviced
+        // by run() without leaving it
+        Irq   = Bus::Line::Irq,
+        Nmi   = Bus::Line::Nmi,
+        Reset = Bus::Line::Reset,
+
+        // Device event scheduled before loop stop cycle
+        Due   = Scheduler::Due,
+
+        // Breakpoint or watchpoint hit, cleared by next run() or runUntil()
+        Break = Bus::Watch,
+
+        // JAM executed, only reset leaves it
+        Halt  = 1 << 7
+    };
+
+    uint8_t events = 0;
+
+    //
+    // Set to 1 when indexed addressing crosses page boundary
+    // Only read for commands with page boundary penalty, which
+    // always use modes that set it, so it is never cleared
+    //
+
+    uint8_t cross = 0;
+
+    //
+    // Event raised by jump or branch to itself
+    // Zero when trap detection is disabled
+    //
+
+    uint8_t trapping = 0;
+
+    // Selected interpreter backend
+    Backend backend;
+
     //
     // OP   Current operand (Example: ADD #OP)
     //      This variable is set depending on current addressing mode
@@ -125,21 +207,82 @@ private:
 
     uint16_t pc = 0x0400;
 
+    //
+    // Total programm cycles executed
+    //
+
+    uint64_t cycles = 0;
+
+    //
+    // Instructions executed
+    //
+
+    uint64_t counter = 0;
+
+    // Addressing memory, reads bus pages directly
+    Mem mem;
+
+    // Predecoded instructions, allocated for cached backend only
+    std::unique_ptr<Cache> cache;
+
+    // Translated blocks, allocated for jit backend only
+    std::unique_ptr<Jit> jit;
+
+    //
+    // Cold state
+    //
+
+    //
+    // Instruction number of last breakpoint hit
+    // Run resumed from breakpoint does not stop on it again
+    //
+
+    uint64_t resumed = std::numeric_limits<uint64_t>::max();
+
+    //
+    // IRQ and NMI taken
+    //
+
+    uint64_t interrupts = 0;
+
+    // Trace filter, tracing is disabled when empty
+    std::unique_ptr<Trace> trace;
 
-    // 6502 instruction mapping (mnemonic table)
-    // Includes all common/undocumented instructions
-    std::unique_ptr<Map> map;
+    // Binary trace sink, text disassembly is used when empty
+    Recorder * recorder = nullptr;
 
-    // Addressing memory
-    std::unique_ptr<Mem> mem;
+    // Execution profiler, profiling is disabled when empty
+    Profile * profile = nullptr;
 
-    // Disassembler
+    // Disassembler, allocated when trace is set
     std::unique_ptr<Log> log;
 
-    // Current processed command
-    const Cmd * cmd;
+    // Keeps bus of shared constructor alive
+    std::shared_ptr<Bus> owner;
 
-    uint32_t counter = 0;
+    //
+    // Run loop instrumentation
+    // Selected at runtime, checks are compiled in only for its loop
+    //
+
+    enum class Probe : uint8_t
+    {
+        None,
+        Break,    // Breakpoints only
+        Traced,
+        Profiled
+    };
+
+    //
+    // Operand location of commands which work on memory or accumulator
+    // Resolved at compile time by the opcode table
+    //
+
+    enum Operand : uint8_t
+    {
+        Memory,
+        Accumulator
+    };
 
     //
     // Addressing modes
@@ -158,6 +301,8 @@ private:
     void INDX(); // X-indexed, indirect
     void INDY(); // indirect, Y-indexed
     void REL();  // relative
+    void ZPI();  // zeropage indirect, 65C02
+    void IAX();  // absolute X-indexed, indirect, 65C02
 
     //
     // Instruction set
@@ -166,17 +311,23 @@ private:
     void ADC(uint8_t arg);
     void CMP(uint8_t arg);
 
+    // Decimal mode ADC and SBC
+    void ADCD(uint8_t arg);
+    void SBCD(uint8_t arg);
+
     void ADC(); // Add Memory to Accumulator with Carry
     void ALR();  // AND opration and LSR
     void ANC();  // AND opration and set C as ASL
     void AND();  // AND Memory with Accumulator
     void ANE();  // (A OR CONST) and X "AND" operation
     void ARR();  // AND opration and ROR
+    template <Operand operand = Memory>
     void ASL();  // Shift Left One Bit (Memory or Accumulator)
     void BRA();  // Branch 
     void BCC();  // Branch on Carry Clear
     void BCS();  // Branch on Carry Set
     void BEQ();  // Branch on Result Zero
+    void BIM();  // Test Bits in Immediate with Accumulator, 65C02
     void BIT();  // Test Bits in Memory with Accumulator
     void BMI();  // Branch on Result Minus
     void BNE();  // Branch on Result not Zero
@@ -192,10 +343,12 @@ private:
     void CPX();  // Compare Memory and Index X
     void CPY();  // Compare Memory and Index Y
     void DCP();  // DEC operation and CMP operation
+    void DEA();  // Decrement Accumulator by One, 65C02
     void DEC();  // Decrement Memory by One
     void DEX();  // Decrement Index X by One
     void DEY();  // Decrement Index Y by One
     void EOR();  // "Exclusive-Or" Memory with Accumulator
+    void INA();  // Increment Accumulator by One, 65C02
     void INC();  // Increment Memory by One
     void INX();  // Increment Index X by One
     void INY();  // Increment Index Y by One
@@ -208,16 +361,23 @@ private:
     void LDA();  // Load Accumulator with Memory
     void LDX();  // Load Index X with Memory
     void LDY();  // Load Index Y with Memory
+    template <Operand operand = Memory>
     void LSR();  // Shift Right One Bit (Memory or Accumulator)
     void LXA();  // Store * AND oper in A and X
     void NOP();  // No Operation
     void ORA();  // OR Memory with Accumulator
     void PHA();  // Push Accumulator on Stack
     void PHP();  // Push Processor Status on Stack
+    void PHX();  // Push Index X on Stack, 65C02
+    void PHY();  // Push Index Y on Stack, 65C02
     void PLA();  // Pull Accumulator from Stack
     void PLP();  // Pull Processor Status from Stack
+    void PLX();  // Pull Index X from Stack, 65C02
+    void PLY();  // Pull Index Y from Stack, 65C02
     void RLA();  // ROL operation and AND oper
+    template <Operand operand = Memory>
     void ROL();  // Rotate One Bit Left (Memory or Accumulator)
+    template <Operand operand = Memory>
     void ROR();  // Rotate One Bit Right (Memory or Accumulator)
     void RRA();  // ROR operation and ADC oper
     void RTI();  // Return from Interrupt
@@ -236,9 +396,12 @@ private:
     void STA();  // Store Accumulator in Memory
     void STX();  // Store Index X in Memory
     void STY();  // Store Index Y in Memory
+    void STZ();  // Store Zero in Memory, 65C02
     void TAS();  // Puts A AND X in SP and stores A AND X AND (high-byte of addr. + 1) at addr.
     void TAX();  // Transfer Accumulator to Index X
     void TAY();  // Transfer Accumulator to Index Y
+    void TRB();  // Test and Reset Memory Bits with Accumulator, 65C02
+    void TSB();  // Test and Set Memory Bits with Accumulator, 65C02
     void TSX();  // Transfer Stack Pointer to Index X
     void TXA();  // Transfer Index X to Accumulator
     void TXS();  // Transfer Index X to Stack Pointer
@@ -247,19 +410,176 @@ private:
 
 private:
 
+    // Addressing mode and command of opcode in one handler
+    template <uint8_t opcode>
+    void fused();
+
+    // Execute opcode through fused handlers
+    void dispatch(uint8_t opcode);
+
+    // Fused handler with operand bytes taken from decode cache
+    template <uint8_t opcode>
+    void predecoded(uint16_t operand);
+
+    // Execute opcode through predecoded handlers
+    void predecode(uint8_t opcode, uint16_t operand);
+
+    // Execute instruction at program counter from decode cache
+    // Returns executed operation code
+    uint8_t decoded();
+
+    // Fill cache entry from memory at program counter
+    // Returns false for instruction on device page
+    bool decode(Cache::Entry & entry);
+
+    // Execute translated block at program counter until its end,
+    // cycle or event. Returns false if no block was executed
+    bool translated(uint64_t until);
+
+    // Translate block at program counter
+    // Returns nullptr if first instruction spans two pages or on device page
+    Jit::Block * translate();
+
+    // Fetch and execute one instruction on backend
+    // Returns executed operation code
+    template <Backend backend>
+    uint8_t execute();
+
+    // Fetch and execute one instruction on selected backend
+    // Returns executed operation code
+    uint8_t step();
+
+    // Push program counter and status, jump to vector
+    void interrupt(uint16_t vector);
+
+    // Handle pending interrupts, masked IRQ is dropped until
+    // I flag is cleared. Returns false if Stop, Trap, Break or Halt is pending
+    bool service();
+
+    // Raise IRQ again if line is still held after I flag is cleared
+    void unmask();
+
+    // Dispatch due device events and service pending interrupts
+    // Returns false if Stop, Trap, Break or Halt is pending
+    bool poll();
+
+    // Raise Break if program counter has breakpoint
+    // Returns true if run loop has to leave
+    bool breakpoint();
+
+    // Execute instructions until cycle or event
+    // Trace, profile and breakpoint checks are compiled in only 
+    // for their loops
+    template <Backend backend, Probe probe>
+    void loop(uint64_t until);
+
+    // Select profiled, traced, breakpoint or plain loop at runtime
+    template <Backend backend>
+    void loop(uint64_t until);
+
+    // Pass instruction to disassembler or recorder if trace accepts it
+    void print(uint16_t pc, uint8_t opcode) const;
+
     // Read data from memory/accumulator
+    template <Operand operand = Memory>
     uint8_t read() const;
 
     // Write data to memory or accumulator
+    template <Operand operand = Memory>
     void write (uint8_t data);
 
 
 public:
-    Cpu(std::shared_ptr<Bus> bus);
+    Cpu(std::shared_ptr<Bus> bus, Backend backend = Backend::Table);
+
+    // Bus is not owned and must outlive Cpu, lets machines
+    // be placed in one block without heap allocation
+    Cpu(Bus & bus, Backend backend = Backend::Table);
 
+    // Service pending interrupt and execute single instruction
     void clock();
+
+    // Load program counter from RESET vector at $FFFC
     void reset();
 
+    /*
+        Execute instructions until cycle budget is exhausted
+        or an event is pending. Returns executed cycles
+    */
+    uint64_t run(uint64_t budget);
+
+    /*
+        Execute instructions until predicate returns true,
+        budget is exhausted, an event is pending or
+        a breakpoint is reached.
+        Returns executed cycles
+
+        Predicate is called with Cpu before each instruction,
+        prefer run() when no per-instruction check is needed
+    */
+    template <typename Predicate>
+    uint64_t runUntil(Predicate predicate, uint64_t budget = std::numeric_limits<uint64_t>::max())
+    {
+        auto start = cycles;
+
+        // Continue from breakpoint or watchpoint
+        events &= ~Event::Break;
+
+        while (cycles - start < budget && !predicate(*this)) 
+        {
+            if (!poll())
+                break;
+
+            if (mem.getBus().hasBreakpoints() && breakpoint())
+                break;
+
+            step();
+        }
+
+        events &= ~Event::Stop;
+        return cycles - start;
+    }
+
+    // Make run loop return at next instruction boundary
+    void stop();
+
+    // Stop run loop for good at jump or branch to itself,
+    // program counter is left at the trap instruction
+    void setTrapDetection(bool enabled);
+
+    // Returns true if run loop was stopped by trap
+    bool isTrapped() const;
+
+    // Returns true if run loop was stopped by breakpoint or
+    // watchpoint, bus tells which one was hit
+    bool isBreak() const;
+
+    // Returns true if CPU is halted by JAM until reset
+    bool isHalted() const;
+
+    // Returns program counter
+    uint16_t getPc() const;
+
+    // Returns total instructions executed
+    uint64_t getInstructions() const;
+
+    // Enable tracing with filter or disable it with nullptr
+    void setTrace(std::unique_ptr<Trace> trace);
+
+    // Send traced instructions to binary recorder instead of
+    // text disassembly. Recorder must outlive run loop
+    void setRecorder(Recorder * recorder);
+
+    // Count executed instructions in profiler or disable it with nullptr
+    // Profiler must outlive run loop
+    void setProfile(Profile * profile);
+
+    // Returns total programm cycles executed
+    uint64_t getCycles() const;
+
+    // Returns counters of CPU, its memory, decode caches and bus devices
+    Stats getStats() const;
+
     ~Cpu();
 };
 
@@ -0,0 +1,225 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bus/bus.h"
+
+class Cpu;
+
+//
+// Block translator
+//
+// Hot basic blocks are translated into threaded code: a list of
+// handlers with operand bytes, addressing mode and cycles bound at
+// translation time. Block bytes are marked as code on the bus, and
+// write to any of them makes block stale. Block never leaves its
+// 256-byte page, so only blocks starting on written page are looked
+// at. Device pages are never translated
+//
+
+class Jit
+{
+public:
+
+    using Handler = void (Cpu::*)(uint16_t);
+
+    struct Instruction
+    {
+        /*
+            Predecoded handler of operation code
+        */
+        Handler handler;
+
+        /*
+            Operand bytes following operation code (lo | hi << 8)
+        */
+        uint16_t operand;
+
+        uint8_t opcode;
+
+        /*
+            Base cycles & page boundary penalty from opcode table
+        */
+        uint8_t cycles;
+        uint8_t penalty;
+    };
+
+    struct Block
+    {
+        /*
+            Code bytes from start address
+        */
+        uint16_t bytes = 0;
+
+        /*
+            Block bytes were written, block is dropped on next lookup
+        */
+        bool stale = false;
+
+        /*
+            Block starts at breakpoint, it is never entered by chaining
+        */
+        bool breakpoint = false;
+
+        /*
+            Sequential instructions, only last one may jump
+        */
+        std::vector<Instruction> code;
+    };
+
+    /*
+        Block entries before translation
+    */
+    static constexpr uint16_t threshold = 32;
+
+    /*
+        Maximum instructions per block
+    */
+    static constexpr std::size_t limit = 64;
+
+private:
+
+    /*
+        Translated blocks by start address
+    */
+    std::unique_ptr<std::unique_ptr<Block>[]> blocks;
+
+    /*
+        Block entries by start address
+    */
+    std::unique_ptr<uint16_t[]> hits;
+
+    /*
+        Bus holding cached code
+    */
+    Bus & bus;
+
+    uint64_t lookups      = 0;
+    uint64_t found        = 0;
+    uint64_t translations = 0;
+    uint64_t drops        = 0;
+
+public:
+
+    /*
+        Tracks translated code on bus until Cpu stops tracking it
+    */
+    Jit(Bus & bus) :
+        blocks(std::make_unique<std::unique_ptr<Block>[]>(64 * 1024)),
+        hits(std::make_unique<uint16_t[]>(64 * 1024)),
+        bus(bus)
+    { 
+        bus.track([this](uint16_t address) { invalidate(address); });
+    }
+
+    /*
+        Returns true if code at address may be translated
+    */
+    bool cacheable(uint16_t pc) const {
+        return bus.isDirect(pc);
+    }
+
+    /*
+        Make blocks containing address stale
+        Running block is left at its next instruction
+    */
+    void invalidate(uint16_t address)
+    {
+        for (unsigned pc = address & 0xFF00; pc <= address; pc++) 
+        {
+            auto & block = blocks[pc];
+
+            if (block && pc + block -> bytes > address) {
+                block -> stale = true;
+            }
+        }
+    }
+
+    /*
+        Returns translated block at address or nullptr
+
+        Modified block is dropped and its hit counter restarted,
+        so self-modifying code stays in interpreter until it is
+        hot again
+    */
+    Block * find(uint16_t pc)
+    {
+        auto & block = blocks[pc];
+
+        lookups++;
+
+        if (block && block -> stale) 
+        {
+            block.reset();
+            hits[pc] = 0;
+
+            drops++;
+        }
+
+        found += block != nullptr;
+
+        return block.get();
+    }
+
+    /*
+        Count block entry, returns true once address became hot
+    */
+    bool hot(uint16_t pc) {
+        return ++hits[pc] == threshold;
+    }
+
+    /*
+        Store translated block, mark its bytes as code
+    */
+    Block * insert(uint16_t pc, std::unique_ptr<Block> block) 
+    {
+        bus.markCode(pc, block -> bytes);
+
+        blocks[pc] = std::move(block);
+        translations++;
+
+        return blocks[pc].get();
+    }
+
+    /*
+        Returns number of block lookups, found blocks, 
+        translations and blocks dropped after write
+    */
+    uint64_t getLookups() const {
+        return lookups;
+    }
+
+    uint64_t getHits() const {
+        return found;
+    }
+
+    uint64_t getTranslations() const {
+        return translations;
+    }
+
+    uint64_t getDrops() const {
+        return drops;
+    }
+};
+
+#endif
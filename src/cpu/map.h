@@ -22,9 +22,11 @@
 #include <cstdint>
 
 #include "cmd.h"
+#include "variant.h"
 
 //
 // Command mapping
+// Asterics means illegal operation code
 //
 
 class Map
@@ -35,15 +37,449 @@ private:
     // 6502 Instruction set
     // Includes all common/undocumented instructions
     //
+    // Built at compile time, so every translation unit
+    // sees the handlers as constants
+    //
+    // { cycles, command, addressing mode, page boundary penalty }
+    //
 
-    std::array<Cmd, 256> cmd;
+    static constexpr std::array<Cmd, 256> nmos =
+    {{
+        // 0x00 - 0x0F
+
+        { 7, &Cpu::BRK, &Cpu::IMP  }, // 0x00
+        { 6, &Cpu::ORA, &Cpu::INDX }, // 0x01
+        { 1, &Cpu::JAM, &Cpu::IMP  }, // 0x02 *
+        { 8, &Cpu::SLO, &Cpu::INDX }, // 0x03 *
+        { 3, &Cpu::NOP, &Cpu::ZPG  }, // 0x04 *
+        { 3, &Cpu::ORA, &Cpu::ZPG  }, // 0x05
+        { 5, &Cpu::ASL<Cpu::Memory>, &Cpu::ZPG  }, // 0x06
+        { 5, &Cpu::SLO, &Cpu::ZPG  }, // 0x07 *
+        { 3, &Cpu::PHP, &Cpu::IMP  }, // 0x08
+        { 2, &Cpu::ORA, &Cpu::IMM  }, // 0x09
+        { 2, &Cpu::ASL<Cpu::Accumulator>, &Cpu::ACC  }, // 0x0A
+        { 2, &Cpu::ANC, &Cpu::IMM  }, // 0x0B *
+        { 4, &Cpu::NOP, &Cpu::ABS  }, // 0x0C *
+        { 4, &Cpu::ORA, &Cpu::ABS  }, // 0x0D
+        { 6, &Cpu::ASL<Cpu::Memory>, &Cpu::ABS  }, // 0x0E
+        { 6, &Cpu::SLO, &Cpu::ABS  }, // 0x0F *
+
+
+        // 0x10 - 0x1F
+
+        { 2, &Cpu::BPL, &Cpu::REL  }, // 0x10
+        { 5, &Cpu::ORA, &Cpu::INDY, 1 }, // 0x11
+        { 1, &Cpu::JAM, &Cpu::IMP  }, // 0x12 *
+        { 8, &Cpu::SLO, &Cpu::INDY }, // 0x13 *
+        { 4, &Cpu::NOP, &Cpu::ZPGX }, // 0x14 *
+        { 4, &Cpu::ORA, &Cpu::ZPGX }, // 0x15
+        { 6, &Cpu::ASL<Cpu::Memory>, &Cpu::ZPGX }, // 0x16
+        { 6, &Cpu::SLO, &Cpu::ZPGX }, // 0x17 *
+        { 2, &Cpu::CLC, &Cpu::IMP  }, // 0x18
+        { 4, &Cpu::ORA, &Cpu::ABSY, 1 }, // 0x19
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0x1A *
+        { 7, &Cpu::SLO, &Cpu::ABSY }, // 0x1B *
+        { 4, &Cpu::NOP, &Cpu::ABSX, 1 }, // 0x1C *
+        { 4, &Cpu::ORA, &Cpu::ABSX, 1 }, // 0x1D
+        { 7, &Cpu::ASL<Cpu::Memory>, &Cpu::ABSX }, // 0x1E
+        { 7, &Cpu::SLO, &Cpu::ABSX }, // 0x1F *
+
+
+        // 0x20 - 0x2F
+
+        { 6, &Cpu::JSR, &Cpu::ABS  }, // 0X20
+        { 6, &Cpu::AND, &Cpu::INDX }, // 0X21
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0X22 *
+        { 8, &Cpu::RLA, &Cpu::INDX }, // 0X23 *
+        { 3, &Cpu::BIT, &Cpu::ZPG  }, // 0X24
+        { 3, &Cpu::AND, &Cpu::ZPG  }, // 0X25
+        { 5, &Cpu::ROL<Cpu::Memory>, &Cpu::ZPG  }, // 0X26
+        { 5, &Cpu::RLA, &Cpu::ZPG  }, // 0X27 *
+        { 4, &Cpu::PLP, &Cpu::IMP  }, // 0X28
+        { 2, &Cpu::AND, &Cpu::IMM  }, // 0X29
+        { 2, &Cpu::ROL<Cpu::Accumulator>, &Cpu::ACC  }, // 0X2A
+        { 2, &Cpu::ANC, &Cpu::IMM  }, // 0X2B *
+        { 4, &Cpu::BIT, &Cpu::ABS  }, // 0X2C
+        { 4, &Cpu::AND, &Cpu::ABS  }, // 0X2D
+        { 6, &Cpu::ROL<Cpu::Memory>, &Cpu::ABS  }, // 0X2E
+        { 6, &Cpu::RLA, &Cpu::ABS  }, // 0X2F *
+
+
+        // 0x30 - 0x3F
+
+        { 2, &Cpu::BMI, &Cpu::REL  }, // 0x30
+        { 5, &Cpu::AND, &Cpu::INDY, 1 }, // 0x31
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0x32 *
+        { 8, &Cpu::RLA, &Cpu::INDY }, // 0x33 *
+        { 4, &Cpu::NOP, &Cpu::ZPGX }, // 0x34 *
+        { 4, &Cpu::AND, &Cpu::ZPGX }, // 0x35
+        { 6, &Cpu::ROL<Cpu::Memory>, &Cpu::ZPGX }, // 0x36
+        { 6, &Cpu::RLA, &Cpu::ZPGX }, // 0x37 *
+        { 2, &Cpu::SEC, &Cpu::IMP  }, // 0x38
+        { 4, &Cpu::AND, &Cpu::ABSY, 1 }, // 0x39
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0x3A *
+        { 7, &Cpu::RLA, &Cpu::ABSY }, // 0x3B *
+        { 4, &Cpu::NOP, &Cpu::ABSX, 1 }, // 0x3C *
+        { 4, &Cpu::AND, &Cpu::ABSX, 1 }, // 0x3D
+        { 7, &Cpu::ROL<Cpu::Memory>, &Cpu::ABSX }, // 0x3E
+        { 7, &Cpu::RLA, &Cpu::ABSX }, // 0x3F *
+
+
+        // 0x40 - 0x4F
+
+        { 6, &Cpu::RTI, &Cpu::IMP  }, // 0x40
+        { 6, &Cpu::EOR, &Cpu::INDX }, // 0x41
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0x42 *
+        { 8, &Cpu::SRE, &Cpu::INDX }, // 0x43 *
+        { 3, &Cpu::NOP, &Cpu::ZPG  }, // 0x44 *
+        { 3, &Cpu::EOR, &Cpu::ZPG  }, // 0x45
+        { 5, &Cpu::LSR<Cpu::Memory>, &Cpu::ZPG  }, // 0x46
+        { 5, &Cpu::SRE, &Cpu::ZPG  }, // 0x47 *
+        { 3, &Cpu::PHA, &Cpu::IMP  }, // 0x48
+        { 2, &Cpu::EOR, &Cpu::IMM  }, // 0x49
+        { 2, &Cpu::LSR<Cpu::Accumulator>, &Cpu::ACC  }, // 0x4A
+        { 2, &Cpu::ALR, &Cpu::IMM  }, // 0x4B *
+        { 3, &Cpu::JMP, &Cpu::ABS  }, // 0x4C
+        { 4, &Cpu::EOR, &Cpu::ABS  }, // 0x4D
+        { 6, &Cpu::LSR<Cpu::Memory>, &Cpu::ABS  }, // 0x4E
+        { 6, &Cpu::SRE, &Cpu::ABS  }, // 0x4F *
+
+
+        // 0x50 - 0x5F
+
+        { 2, &Cpu::BVC, &Cpu::REL  }, // 0x50
+        { 5, &Cpu::EOR, &Cpu::INDY, 1 }, // 0x51
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0x52 *
+        { 8, &Cpu::SRE, &Cpu::INDY }, // 0x53 *
+        { 4, &Cpu::NOP, &Cpu::ZPGX }, // 0x54 *
+        { 4, &Cpu::EOR, &Cpu::ZPGX }, // 0x55
+        { 6, &Cpu::LSR<Cpu::Memory>, &Cpu::ZPGX }, // 0x56
+        { 6, &Cpu::SRE, &Cpu::ZPGX }, // 0x57 *
+        { 2, &Cpu::CLI, &Cpu::IMP  }, // 0x58
+        { 4, &Cpu::EOR, &Cpu::ABSY, 1 }, // 0x59
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0x5A *
+        { 7, &Cpu::SRE, &Cpu::ABSY }, // 0x5B *
+        { 4, &Cpu::NOP, &Cpu::ABSX, 1 }, // 0x5C *
+        { 4, &Cpu::EOR, &Cpu::ABSX, 1 }, // 0x5D
+        { 7, &Cpu::LSR<Cpu::Memory>, &Cpu::ABSX }, // 0x5E
+        { 7, &Cpu::SRE, &Cpu::ABSX }, // 0x5F *
+
+
+        // 0x60 - 0x6F
+
+        { 6, &Cpu::RTS, &Cpu::IMP  }, // 0x60
+        { 6, &Cpu::ADC, &Cpu::INDX }, // 0x61
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0x62 *
+        { 8, &Cpu::RRA, &Cpu::INDX }, // 0x63 *
+        { 3, &Cpu::NOP, &Cpu::ZPG  }, // 0x64 *
+        { 3, &Cpu::ADC, &Cpu::ZPG  }, // 0x65
+        { 5, &Cpu::ROR<Cpu::Memory>, &Cpu::ZPG  }, // 0x66
+        { 5, &Cpu::RRA, &Cpu::ZPG  }, // 0x67 *
+        { 4, &Cpu::PLA, &Cpu::IMP  }, // 0x68
+        { 2, &Cpu::ADC, &Cpu::IMM  }, // 0x69
+        { 2, &Cpu::ROR<Cpu::Accumulator>, &Cpu::ACC  }, // 0x6A
+        { 2, &Cpu::ARR, &Cpu::IMM  }, // 0x6B *
+        { 5, &Cpu::JMP, &Cpu::IND  }, // 0x6C
+        { 4, &Cpu::ADC, &Cpu::ABS  }, // 0x6D
+        { 6, &Cpu::ROR<Cpu::Memory>, &Cpu::ABS  }, // 0x6E
+        { 6, &Cpu::RRA, &Cpu::ABS  }, // 0x6F *
+
+
+        // 0x70 - 0x7F
+
+        { 2, &Cpu::BVS, &Cpu::REL  }, // 0x70
+        { 5, &Cpu::ADC, &Cpu::INDY, 1 }, // 0x71
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0x72 *
+        { 8, &Cpu::RRA, &Cpu::INDY }, // 0x73 *
+        { 4, &Cpu::NOP, &Cpu::ZPGX }, // 0x74 *
+        { 4, &Cpu::ADC, &Cpu::ZPGX }, // 0x75
+        { 6, &Cpu::ROR<Cpu::Memory>, &Cpu::ZPGX }, // 0x76
+        { 6, &Cpu::RRA, &Cpu::ZPGX }, // 0x77 *
+        { 2, &Cpu::SEI, &Cpu::IMP  }, // 0x78
+        { 4, &Cpu::ADC, &Cpu::ABSY, 1 }, // 0x79
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0x7A *
+        { 7, &Cpu::RRA, &Cpu::ABSY }, // 0x7B *
+        { 4, &Cpu::NOP, &Cpu::ABSX, 1 }, // 0x7C *
+        { 4, &Cpu::ADC, &Cpu::ABSX, 1 }, // 0x7D
+        { 7, &Cpu::ROR<Cpu::Memory>, &Cpu::ABSX }, // 0x7E
+        { 7, &Cpu::RRA, &Cpu::ABSX }, // 0x7F *
+
+
+        // 0x80 - 0x8F
+
+        { 2, &Cpu::NOP, &Cpu::IMM  }, // 0x80 *
+        { 6, &Cpu::STA, &Cpu::INDX }, // 0x81
+        { 2, &Cpu::NOP, &Cpu::IMM  }, // 0x82 *
+        { 6, &Cpu::SAX, &Cpu::INDX }, // 0x83 *
+        { 3, &Cpu::STY, &Cpu::ZPG  }, // 0x84
+        { 3, &Cpu::STA, &Cpu::ZPG  }, // 0x85
+        { 3, &Cpu::STX, &Cpu::ZPG  }, // 0x86
+        { 3, &Cpu::SAX, &Cpu::ZPG  }, // 0x87 *
+        { 2, &Cpu::DEY, &Cpu::IMP  }, // 0x88
+        { 2, &Cpu::NOP, &Cpu::IMM  }, // 0x89 *
+        { 2, &Cpu::TXA, &Cpu::IMP  }, // 0x8A
+        { 2, &Cpu::ANE, &Cpu::IMM  }, // 0x8B *
+        { 4, &Cpu::STY, &Cpu::ABS  }, // 0x8C
+        { 4, &Cpu::STA, &Cpu::ABS  }, // 0x8D
+        { 4, &Cpu::STX, &Cpu::ABS  }, // 0x8E
+        { 4, &Cpu::SAX, &Cpu::ABS  }, // 0x8F *
+
+
+        // 0x90 - 0x9F
+
+        { 2, &Cpu::BCC, &Cpu::REL  }, // 0x90
+        { 6, &Cpu::STA, &Cpu::INDY }, // 0x91
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0x92 *
+        { 6, &Cpu::SHA, &Cpu::INDY }, // 0x93 *
+        { 4, &Cpu::STY, &Cpu::ZPGX }, // 0x94
+        { 4, &Cpu::STA, &Cpu::ZPGX }, // 0x95
+        { 4, &Cpu::STX, &Cpu::ZPGY }, // 0x96
+        { 4, &Cpu::SAX, &Cpu::ZPGY }, // 0x97 *
+        { 2, &Cpu::TYA, &Cpu::IMP  }, // 0x98
+        { 5, &Cpu::STA, &Cpu::ABSY }, // 0x99
+        { 2, &Cpu::TXS, &Cpu::IMP  }, // 0x9A
+        { 5, &Cpu::TAS, &Cpu::ABSY }, // 0x9B *
+        { 5, &Cpu::SHY, &Cpu::ABSX }, // 0x9C *
+        { 5, &Cpu::STA, &Cpu::ABSX }, // 0x9D
+        { 5, &Cpu::SHX, &Cpu::ABSY }, // 0x9E *
+        { 5, &Cpu::SHA, &Cpu::ABSY }, // 0x9F *
+
+
+        // 0xA0 - 0xAF
+
+        { 2, &Cpu::LDY, &Cpu::IMM  }, // 0xA0
+        { 6, &Cpu::LDA, &Cpu::INDX }, // 0xA1
+        { 2, &Cpu::LDX, &Cpu::IMM  }, // 0xA2
+        { 6, &Cpu::LAX, &Cpu::INDX }, // 0xA3 *
+        { 3, &Cpu::LDY, &Cpu::ZPG  }, // 0xA4
+        { 3, &Cpu::LDA, &Cpu::ZPG  }, // 0xA5
+        { 3, &Cpu::LDX, &Cpu::ZPG  }, // 0xA6
+        { 3, &Cpu::LAX, &Cpu::ZPG  }, // 0xA7 *
+        { 2, &Cpu::TAY, &Cpu::IMP  }, // 0xA8
+        { 2, &Cpu::LDA, &Cpu::IMM  }, // 0xA9
+        { 2, &Cpu::TAX, &Cpu::IMP  }, // 0xAA
+        { 2, &Cpu::LXA, &Cpu::IMM  }, // 0xAB *
+        { 4, &Cpu::LDY, &Cpu::ABS  }, // 0xAC
+        { 4, &Cpu::LDA, &Cpu::ABS  }, // 0xAD
+        { 4, &Cpu::LDX, &Cpu::ABS  }, // 0xAE
+        { 4, &Cpu::LAX, &Cpu::ABS  }, // 0xAF *
 
-public:
 
-    Map();
+        // 0xB0 - 0xBF
+
+        { 2, &Cpu::BCS, &Cpu::REL  }, // 0xB0
+        { 5, &Cpu::LDA, &Cpu::INDY, 1 }, // 0xB1
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0xB2 *
+        { 5, &Cpu::LAX, &Cpu::INDY, 1 }, // 0xB3 *
+        { 4, &Cpu::LDY, &Cpu::ZPGX }, // 0xB4
+        { 4, &Cpu::LDA, &Cpu::ZPGX }, // 0xB5
+        { 4, &Cpu::LDX, &Cpu::ZPGY }, // 0xB6
+        { 4, &Cpu::LAX, &Cpu::ZPGY }, // 0xB7 *
+        { 2, &Cpu::CLV, &Cpu::IMP  }, // 0xB8
+        { 4, &Cpu::LDA, &Cpu::ABSY, 1 }, // 0xB9
+        { 2, &Cpu::TSX, &Cpu::IMP  }, // 0xBA
+        { 4, &Cpu::LAS, &Cpu::ABSY, 1 }, // 0xBB *
+        { 4, &Cpu::LDY, &Cpu::ABSX, 1 }, // 0xBC
+        { 4, &Cpu::LDA, &Cpu::ABSX, 1 }, // 0xBD
+        { 4, &Cpu::LDX, &Cpu::ABSY, 1 }, // 0xBE
+        { 4, &Cpu::LAX, &Cpu::ABSY, 1 }, // 0xBF *
+
+
+        // 0xC0 - 0xCF
+
+        { 2, &Cpu::CPY, &Cpu::IMM  }, // 0xC0
+        { 6, &Cpu::CMP, &Cpu::INDX }, // 0xC1
+        { 2, &Cpu::NOP, &Cpu::IMM  }, // 0xC2 *
+        { 8, &Cpu::DCP, &Cpu::INDX }, // 0xC3 *
+        { 3, &Cpu::CPY, &Cpu::ZPG  }, // 0xC4
+        { 3, &Cpu::CMP, &Cpu::ZPG  }, // 0xC5
+        { 5, &Cpu::DEC, &Cpu::ZPG  }, // 0xC6
+        { 5, &Cpu::DCP, &Cpu::ZPG  }, // 0xC7 *
+        { 2, &Cpu::INY, &Cpu::IMP  }, // 0xC8
+        { 2, &Cpu::CMP, &Cpu::IMM  }, // 0xC9
+        { 2, &Cpu::DEX, &Cpu::IMP  }, // 0xCA
+        { 2, &Cpu::SBX, &Cpu::IMM  }, // 0xCB *
+        { 4, &Cpu::CPY, &Cpu::ABS  }, // 0xCC
+        { 4, &Cpu::CMP, &Cpu::ABS  }, // 0xCD
+        { 6, &Cpu::DEC, &Cpu::ABS  }, // 0xCE
+        { 6, &Cpu::DCP, &Cpu::ABS  }, // 0xCF *
+
+
+        // 0xD0 - 0xDF
+
+        { 2, &Cpu::BNE, &Cpu::REL  }, // 0xD0
+        { 5, &Cpu::CMP, &Cpu::INDY, 1 }, // 0xD1
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0xD2 *
+        { 8, &Cpu::DCP, &Cpu::INDY }, // 0xD3 *
+        { 4, &Cpu::NOP, &Cpu::ZPGX }, // 0xD4 *
+        { 4, &Cpu::CMP, &Cpu::ZPGX }, // 0xD5
+        { 6, &Cpu::DEC, &Cpu::ZPGX }, // 0xD6
+        { 6, &Cpu::DCP, &Cpu::ZPGX }, // 0xD7 *
+        { 2, &Cpu::CLD, &Cpu::IMP  }, // 0xD8
+        { 4, &Cpu::CMP, &Cpu::ABSY, 1 }, // 0xD9
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0xDA *
+        { 7, &Cpu::DCP, &Cpu::ABSY }, // 0xDB *
+        { 4, &Cpu::NOP, &Cpu::ABSX, 1 }, // 0xDC *
+        { 4, &Cpu::CMP, &Cpu::ABSX, 1 }, // 0xDD
+        { 7, &Cpu::DEC, &Cpu::ABSX }, // 0xDE
+        { 7, &Cpu::DCP, &Cpu::ABSX }, // 0xDF *
+
+
+        // 0xE0 - 0xEF
+
+        { 2, &Cpu::CPX, &Cpu::IMM  }, // 0xE0
+        { 6, &Cpu::SBC, &Cpu::INDX }, // 0xE1
+        { 2, &Cpu::NOP, &Cpu::IMM  }, // 0xE2 *
+        { 8, &Cpu::ISC, &Cpu::INDX }, // 0xE3 *
+        { 3, &Cpu::CPX, &Cpu::ZPG  }, // 0xE4
+        { 3, &Cpu::SBC, &Cpu::ZPG  }, // 0xE5
+        { 5, &Cpu::INC, &Cpu::ZPG  }, // 0xE6
+        { 5, &Cpu::ISC, &Cpu::ZPG  }, // 0xE7 *
+        { 2, &Cpu::INX, &Cpu::IMP  }, // 0xE8
+        { 2, &Cpu::SBC, &Cpu::IMM  }, // 0xE9
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0xEA
+        { 2, &Cpu::USB, &Cpu::IMM  }, // 0xEB *
+        { 4, &Cpu::CPX, &Cpu::ABS  }, // 0xEC
+        { 4, &Cpu::SBC, &Cpu::ABS  }, // 0xED
+        { 6, &Cpu::INC, &Cpu::ABS  }, // 0xEE
+        { 6, &Cpu::ISC, &Cpu::ABS  }, // 0xEF *
+
+
+        // 0xF0 - 0xFF
+
+        { 2, &Cpu::BEQ, &Cpu::REL  }, // 0xF0
+        { 5, &Cpu::SBC, &Cpu::INDY, 1 }, // 0xF1
+        { 2, &Cpu::JAM, &Cpu::IMP  }, // 0xF2 *
+        { 8, &Cpu::ISC, &Cpu::INDY }, // 0xF3 *
+        { 4, &Cpu::NOP, &Cpu::ZPGX }, // 0xF4 *
+        { 4, &Cpu::SBC, &Cpu::ZPGX }, // 0xF5
+        { 6, &Cpu::INC, &Cpu::ZPGX }, // 0xF6
+        { 6, &Cpu::ISC, &Cpu::ZPGX }, // 0xF7 *
+        { 2, &Cpu::SED, &Cpu::IMP  }, // 0xF8
+        { 4, &Cpu::SBC, &Cpu::ABSY, 1 }, // 0xF9
+        { 2, &Cpu::NOP, &Cpu::IMP  }, // 0xFA *
+        { 7, &Cpu::ISC, &Cpu::ABSY }, // 0xFB *
+        { 4, &Cpu::NOP, &Cpu::ABSX, 1 }, // 0xFC *
+        { 4, &Cpu::SBC, &Cpu::ABSX, 1 }, // 0xFD
+        { 7, &Cpu::INC, &Cpu::ABSX }, // 0xFE
+        { 7, &Cpu::ISC, &Cpu::ABSX }  // 0xFF *
+    }};
+
+    //
+    // 65C02 changes to NMOS instruction set
+    // Undefined operation codes x3, x7, xB and xF are one cycle 
+    // NOPs besides these
+    //
+    // { operation code, name, command }
+    //
+
+    struct Change
+    {
+        uint8_t opcode;
+        const char * name;
+        Cmd cmd;
+    };
+
+    static constexpr std::array<Change, 46> cmos =
+    {{
+        { 0x02, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0x04, "TSB", { 5, &Cpu::TSB, &Cpu::ZPG  } },
+        { 0x0C, "TSB", { 6, &Cpu::TSB, &Cpu::ABS  } },
+        { 0x12, "ORA", { 5, &Cpu::ORA, &Cpu::ZPI  } },
+        { 0x14, "TRB", { 5, &Cpu::TRB, &Cpu::ZPG  } },
+        { 0x1A, "INC", { 2, &Cpu::INA, &Cpu::IMP  } },
+        { 0x1C, "TRB", { 6, &Cpu::TRB, &Cpu::ABS  } },
+        { 0x1E, "ASL", { 6, &Cpu::ASL<Cpu::Memory>, &Cpu::ABSX, 1 } },
+        { 0x22, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0x32, "AND", { 5, &Cpu::AND, &Cpu::ZPI  } },
+        { 0x34, "BIT", { 4, &Cpu::BIT, &Cpu::ZPGX } },
+        { 0x3A, "DEC", { 2, &Cpu::DEA, &Cpu::IMP  } },
+        { 0x3C, "BIT", { 4, &Cpu::BIT, &Cpu::ABSX, 1 } },
+        { 0x3E, "ROL", { 6, &Cpu::ROL<Cpu::Memory>, &Cpu::ABSX, 1 } },
+        { 0x42, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0x44, "NOP", { 3, &Cpu::NOP, &Cpu::ZPG  } },
+        { 0x52, "EOR", { 5, &Cpu::EOR, &Cpu::ZPI  } },
+        { 0x54, "NOP", { 4, &Cpu::NOP, &Cpu::ZPGX } },
+        { 0x5A, "PHY", { 3, &Cpu::PHY, &Cpu::IMP  } },
+        { 0x5C, "NOP", { 8, &Cpu::NOP, &Cpu::ABS  } },
+        { 0x5E, "LSR", { 6, &Cpu::LSR<Cpu::Memory>, &Cpu::ABSX, 1 } },
+        { 0x62, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0x64, "STZ", { 3, &Cpu::STZ, &Cpu::ZPG  } },
+        { 0x6C, "JMP", { 6, &Cpu::JMP, &Cpu::IND  } },
+        { 0x72, "ADC", { 5, &Cpu::ADC, &Cpu::ZPI  } },
+        { 0x74, "STZ", { 4, &Cpu::STZ, &Cpu::ZPGX } },
+        { 0x7A, "PLY", { 4, &Cpu::PLY, &Cpu::IMP  } },
+        { 0x7C, "JMP", { 6, &Cpu::JMP, &Cpu::IAX  } },
+        { 0x7E, "ROR", { 6, &Cpu::ROR<Cpu::Memory>, &Cpu::ABSX, 1 } },
+        { 0x80, "BRA", { 2, &Cpu::BRA, &Cpu::REL  } },
+        { 0x82, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0x89, "BIT", { 2, &Cpu::BIM, &Cpu::IMM  } },
+        { 0x92, "STA", { 5, &Cpu::STA, &Cpu::ZPI  } },
+        { 0x9C, "STZ", { 4, &Cpu::STZ, &Cpu::ABS  } },
+        { 0x9E, "STZ", { 5, &Cpu::STZ, &Cpu::ABSX } },
+        { 0xB2, "LDA", { 5, &Cpu::LDA, &Cpu::ZPI  } },
+        { 0xC2, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0xD2, "CMP", { 5, &Cpu::CMP, &Cpu::ZPI  } },
+        { 0xD4, "NOP", { 4, &Cpu::NOP, &Cpu::ZPGX } },
+        { 0xDA, "PHX", { 3, &Cpu::PHX, &Cpu::IMP  } },
+        { 0xDC, "NOP", { 4, &Cpu::NOP, &Cpu::ABS  } },
+        { 0xE2, "NOP", { 2, &Cpu::NOP, &Cpu::IMM  } },
+        { 0xF2, "SBC", { 5, &Cpu::SBC, &Cpu::ZPI  } },
+        { 0xF4, "NOP", { 4, &Cpu::NOP, &Cpu::ZPGX } },
+        { 0xFA, "PLX", { 4, &Cpu::PLX, &Cpu::IMP  } },
+        { 0xFC, "NOP", { 4, &Cpu::NOP, &Cpu::ABS  } }
+    }};
+
+    /*
+        Returns true if 65C02 operation code is one cycle NOP
+    */
+    static constexpr bool isSkipped(uint8_t opcode) {
+        return (opcode & 0x03) == 0x03;
+    }
+
+    //
+    // Instruction set of variant
+    // Template parameter is a variant of cpu/variant.h
+    //
+
+    template <typename V>
+    static constexpr std::array<Cmd, 256> table = [] 
+    {
+        auto table = nmos;
+
+        if constexpr (V::cmos) 
+        {
+            for (std::size_t opcode = 0; opcode < table.size(); opcode++) 
+            {
+                if (isSkipped((uint8_t) opcode)) {
+                    table[opcode] = { 1, &Cpu::NOP, &Cpu::IMP };
+                }
+            }
+
+            for (auto & change : cmos) {
+                table[change.opcode] = change.cmd;
+            }
+        }
+
+        return table;
+    }();
+
+    //
+    // Command names (BRK, ORA etc)
+    // Disassembly only, kept apart from execution data
+    //
+
+    static const std::array<const char *, 256> name;
+
+public:
 
     // Returns command by operation code
-    const Cmd & getCommand(uint8_t opcode) const;
+    static constexpr const Cmd & getCommand(uint8_t opcode) {
+        return table<Variant>[opcode];
+    }
+
+    // Returns command name by operation code
+    static const char * getName(uint8_t opcode);
 };
 
 #endif
\ No newline at end of file
@@ -16,21 +16,13 @@
  */
 
 #include "mem.h"
+#include "variant.h"
 #include "bus/bus.h"
 
-Mem::Mem(std::shared_ptr<Bus> bus) : bus(bus)
+Mem::Mem(Bus & bus) : bus(bus)
 { }
 
 
-/*
-    Read byte from bus
-*/
-uint8_t Mem::read(uint16_t index) const
-{
-    return bus -> read(index);
-}
-
-
 /* 
     Read 2-bytes address from memory direct 
     Shift program counter twice
@@ -53,7 +45,25 @@ uint16_t Mem::direct(uint16_t & pc)
 uint16_t Mem::indirect(uint16_t & pc)
 {
     auto index = direct(pc);
-    return direct(index);
+    return pointer(index);
+}
+
+
+/*
+    Read 2-bytes address of indirect jump
+    NMOS does not carry into high byte of pointer
+*/
+
+uint16_t Mem::pointer(uint16_t address)
+{
+    if constexpr (Variant::cmos) {
+        return direct(address);
+    }
+
+    uint16_t lo = read(address);
+    uint16_t hi = read((address & 0xFF00) | (0x00FF & (address + 1)));
+
+    return (hi << 8) | lo;
 }
 
 
@@ -68,6 +78,21 @@ uint16_t Mem::abs(uint16_t & pc, uint8_t rg)
 } 
 
 
+/*       
+    Absolute indexed mode
+    Sets cross to 1 if index moves address to next page
+*/
+
+uint16_t Mem::abs(uint16_t & pc, uint8_t rg, uint8_t & cross)
+{
+    auto index = direct(pc);
+    uint16_t address = index + rg;
+
+    cross = crossed(index, address);
+    return address;
+}
+
+
 /*
     Zeropage mode
 */
@@ -97,29 +122,16 @@ uint16_t Mem::indexed(uint16_t & pc, uint8_t rg)
 
 
 /*
-    Write byte to bus without carry
+    Zeropage indirect, Y-indexed
+    Sets cross to 1 if index moves address to next page
 */
-void Mem::write(uint16_t address, uint8_t data)
-{
-    bus -> write(address, data);
-}
 
-
-/*
-    Push data on stack
-*/
-void Mem::push(uint8_t & sp, uint8_t data)
+uint16_t Mem::indexed(uint16_t & pc, uint8_t rg, uint8_t & cross)
 {
-    write(beg + sp, data);
-    sp--;
-}
+    auto index = indexed(pc);
+    uint16_t address = index + rg;
 
+    cross = crossed(index, address);
+    return address;
+}
 
-/*
-    Pull data from stack
-*/
-uint8_t Mem::pop(uint8_t & sp)
-{
-    sp++;
-    return read(beg + sp);
-}
\ No newline at end of file
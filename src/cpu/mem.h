@@ -18,10 +18,9 @@
 #ifndef MEM_H
 #define MEM_H
 
-#include <memory>
 #include <cstdint>
 
-class Bus;
+#include "bus/bus.h"
 
 class Mem
 {
@@ -35,21 +34,37 @@ private:
     /*
         Bus communication interface
         Interact with each other devices i.e. RAM, APU, PPU etc.
+        Held by reference, so page table is one load away
     */
-    std::shared_ptr<Bus> bus;
+    Bus & bus;
+
+    /*
+        Stack accesses
+    */
+    uint64_t pushes = 0;
+    uint64_t pops   = 0;
 
 
 public:
 
     /*
-        Initialize with bus
+        Initialize with bus, bus must outlive memory
+    */
+    Mem(Bus & bus);
+
+    /*
+        Returns bus
     */
-    Mem(std::shared_ptr<Bus> bus);
+    Bus & getBus() const {
+        return bus;
+    }
 
     /*
         Read byte from bus
     */
-    uint8_t read(uint16_t index) const;
+    uint8_t read(uint16_t index) const {
+        return bus.read(index);
+    }
 
     /* 
         Read 2-bytes address from memory direct 
@@ -63,11 +78,23 @@ public:
     */
     uint16_t indirect(uint16_t & pc);
 
+    /*
+        Read 2-bytes address of indirect jump at address
+        NMOS takes high byte from same page when address is $xxFF
+    */
+    uint16_t pointer(uint16_t address);
+
     /*       
         Absolute mode
     */
     uint16_t abs(uint16_t & pc, uint8_t rg = 0x00);
 
+    /*
+        Absolute indexed mode
+        Sets cross to 1 if index moves address to next page
+    */
+    uint16_t abs(uint16_t & pc, uint8_t rg, uint8_t & cross);
+
     /*
         Zeropage mode
     */
@@ -78,20 +105,58 @@ public:
     */
     uint16_t indexed(uint16_t & pc, uint8_t rg = 0x00);
 
+    /*
+        Zeropage indirect, Y-indexed
+        Sets cross to 1 if index moves address to next page
+    */
+    uint16_t indexed(uint16_t & pc, uint8_t rg, uint8_t & cross);
+
+    /*
+        Returns 1 if addresses are on different pages
+    */
+    static uint8_t crossed(uint16_t from, uint16_t to) {
+        return ((from ^ to) & 0xFF00) != 0;
+    }
+
     /*
         Write byte to bus without carry
     */
-    void write(uint16_t address, uint8_t data);
+    void write(uint16_t address, uint8_t data) {
+        bus.write(address, data);
+    }
 
     /*
         Push data on stack
     */
-    void push(uint8_t & sp, uint8_t data);
+    void push(uint8_t & sp, uint8_t data) 
+    {
+        write(beg + sp, data);
+        sp--;
+
+        pushes++;
+    }
 
     /*
         Pull data from stack
     */
-    uint8_t pop(uint8_t & sp);
+    uint8_t pop(uint8_t & sp) 
+    {
+        sp++;
+        pops++;
+
+        return read(beg + sp);
+    }
+
+    /*
+        Returns number of stack pushes and pops
+    */
+    uint64_t getPushes() const {
+        return pushes;
+    }
+
+    uint64_t getPops() const {
+        return pops;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -26,8 +26,15 @@ Status::Status() : status(Flags::Default)
 /*
     Restore status from uint8_t
 */
-Status::Status(uint8_t value) : status(value | Flags::Default) 
-{ }
+Status::Status(uint8_t value) : 
+    status   (value & (Flags::Interrupt | Flags::Decimal | Flags::Break)),
+    negative (value & Flags::Negative),
+    zero     (!(value & Flags::Zero)),
+    carry    (value & Flags::Carry),
+    overflow (!!(value & Flags::Overflow))
+{ 
+    status |= Flags::Default;
+}
 
 /*
     Set/Unset flag
@@ -55,20 +62,6 @@ bool Status::isSet(Flags flag) const {
     return (status & flag) == flag;
 }
 
-/*
-    Returns true if Decimal flag is set
-*/
-bool Status::isDecimal() const {
-    return isSet(Flags::Decimal);
-}
-
-/*
-    Returns true if Carry flag is set
-*/
-bool Status::isCarry() const {
-    return isSet(Flags::Carry);
-}
-
 /*
     Returns true if Break flag is set
 */
@@ -76,48 +69,6 @@ bool Status::isBreak() const {
     return isSet(Flags::Break);
 }
 
-/*
-    Returns true if Zero flag is set
-*/
-bool Status::isZero() const {
-    return isSet(Flags::Zero);
-}
-
-/*
-    Returns true if Negative flag is set
-*/
-bool Status::isNegative() const {
-    return isSet(Flags::Negative);
-}
-
-/*
-    Returns true if Overflow flag is set
-*/
-bool Status::isOverflow() const {
-    return isSet(Flags::Overflow);
-}
-
-/*
-    Set/Unset Carry flag
-*/
-void Status::setCarry(bool isSet) {
-    setFlag(Flags::Carry, isSet);
-}
-
-/*
-    Set/Unset Negative flag
-*/
-void Status::setNegative(bool isSet) {
-    setFlag(Flags::Negative, isSet);
-}
-
-/*
-    Set/Unset Negative flag
-*/
-void Status::setOverflow(bool isSet) {
-    setFlag(Flags::Overflow, isSet);
-}
-
 /*
     Set/Unset Decimal flag
 */
@@ -132,13 +83,6 @@ void Status::setInterrupt(bool isSet) {
     setFlag(Flags::Interrupt, isSet);
 }
 
-/*
-    Set/Unset Zero flag
-*/
-void Status::setZero(bool isSet) {
-    setFlag(Flags::Zero, isSet);
-}
-
 /*
     Set/Unset Break flag
 */
@@ -146,27 +90,6 @@ void Status::setBreak(bool isSet) {
     setFlag(Flags::Break, isSet);
 }
 
-/*
-    Returns Carry flag
-*/
-uint8_t Status::getCarry() const {
-    return getFlag(Flags::Carry);
-}
-
-/*
-    Returns Negative flag
-*/
-uint8_t Status::getNegative() const {
-    return getFlag(Flags::Negative);
-}
-
-/*
-    Returns Overflow flag
-*/
-uint8_t Status::getOverflow() const {
-    return getFlag(Flags::Overflow);
-}
-
 /*
     Returns Break flag
 */
@@ -188,13 +111,6 @@ uint8_t Status::getDecimal() const {
     return getFlag(Flags::Decimal);
 }
 
-/*
-    Returns Zero flag
-*/
-uint8_t Status::getZero() const {
-    return getFlag(Flags::Zero);
-}
-
 /*
     Returns Default flag
 */
@@ -205,6 +121,13 @@ uint8_t Status::getDefault() const {
 /*
     Explicit cast to uint8_t
 */
-Status::operator uint8_t() const {
-    return status | Flags::Break | Flags::Default;
+Status::operator uint8_t() const 
+{
+    return status 
+        | Flags::Break 
+        | Flags::Default
+        | (negative & Flags::Negative)
+        | (zero == 0 ? Flags::Zero : 0)
+        | (carry ? Flags::Carry : 0)
+        | (overflow ? Flags::Overflow : 0);
 }
\ No newline at end of file
@@ -41,10 +41,28 @@ private:
     };
 
     /*
-        Status flags value
+        Interrupt, Decimal, Break and Default flags value
+        Other flags are kept apart and only merged on read
     */
     uint8_t status;
 
+    /*
+        Lazy flags
+
+        ALU commands set N, Z, C and V almost every instruction, 
+        mostly to be overwritten before anyone reads them. Each
+        setter is a plain store, flags are materialized by getters
+
+        negative - Negative flag is bit 7
+        zero     - Zero flag is set when value is zero
+        carry    - Carry flag, 0 or 1
+        overflow - Overflow flag, 0 or 1
+    */
+    uint8_t negative = 0;
+    uint8_t zero     = 1;
+    uint8_t carry    = 0;
+    uint8_t overflow = 0;
+
     /*
         Returns true if flag is set
     */
@@ -78,44 +96,52 @@ public:
     */
     template<typename T> 
     void setCarry(const T & value) {
-        setFlag(Flags::Carry, value & 0x100);
+        carry = (value & 0x100) != 0;
     }
 
     /*
         Set/Unset Carry flag
     */
-    void setCarry(bool isSet);
+    void setCarry(bool isSet) {
+        carry = isSet;
+    }
 
     /*
         Test Negative flag by value
     */
     template<typename T> 
     void setNegative(const T & value) {
-        setFlag(Flags::Negative, value & 0x80);
+        negative = static_cast<uint8_t>(value);
     }
 
     /*
         Set/Unset Negative flag
     */
-    void setNegative(bool isSet);
+    void setNegative(bool isSet) {
+        negative = isSet ? Flags::Negative : 0;
+    }
 
     /*
         Test Zero flag by value
     */
     template<typename T> 
     void setZero(const T & value) {
-        setFlag(Flags::Zero, (value & 0x00FF) == 0x00);
+        zero = static_cast<uint8_t>(value);
     }
 
     /*
         Set/Unset Zero flag
     */
-    void setZero(bool isSet);
+    void setZero(bool isSet) {
+        zero = !isSet;
+    }
     
     /*
         Set/Unset Overflow flag
     */
-    void setOverflow(bool isSet);
+    void setOverflow(bool isSet) {
+        overflow = isSet;
+    }
 
     /*
         Set/Unset Decimal flag
@@ -135,17 +161,23 @@ public:
     /*
         Returns Carry flag
     */
-    uint8_t getCarry() const;
+    uint8_t getCarry() const {
+        return carry;
+    }
 
     /*
         Returns Negative flag
     */
-    uint8_t getNegative() const;
+    uint8_t getNegative() const {
+        return negative >> 7;
+    }
 
     /*
         Returns Overflow flag
     */
-    uint8_t getOverflow() const;
+    uint8_t getOverflow() const {
+        return overflow;
+    }
 
     /*
         Returns Break flag
@@ -165,7 +197,9 @@ public:
     /*
         Returns Zero flag
     */
-    uint8_t getZero() const;
+    uint8_t getZero() const {
+        return zero == 0;
+    }
 
     /*
         Returns Default flag
@@ -175,12 +209,16 @@ public:
     /*
         Returns true if Decimal flag is set
     */
-    bool isDecimal() const;
+    bool isDecimal() const {
+        return status & Flags::Decimal;
+    }
 
     /*
         Returns true if Carry flag is set
     */
-    bool isCarry() const;
+    bool isCarry() const {
+        return carry;
+    }
 
     /*
         Returns true if Break flag is set
@@ -190,17 +228,23 @@ public:
     /*
         Returns true if Negative flag is set
     */
-    bool isNegative() const;
+    bool isNegative() const {
+        return negative & Flags::Negative;
+    }
 
     /*
         Returns true if Overflow flag is set
     */
-    bool isOverflow() const;
+    bool isOverflow() const {
+        return overflow;
+    }
 
     /*
-        Returns true if Carry flag is set
+        Returns true if Zero flag is set
     */
-    bool isZero() const;
+    bool isZero() const {
+        return zero == 0;
+    }
 
     /*
         Explicit cast to uint8_t
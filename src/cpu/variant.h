@@ -0,0 +1,67 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VARIANT_H
+#define VARIANT_H
+
+//
+// CPU variants
+//
+// Chosen at build time by CPU_VARIANT option. Opcode table of
+// variant is built at compile time and handlers test its traits
+// with if constexpr, so features missing on variant are compiled
+// out of the interpreter
+//
+
+/*
+    MOS 6502 (NMOS), JAM halts CPU until reset
+*/
+struct Nmos
+{
+    static constexpr bool decimal = true;
+    static constexpr bool cmos    = false;
+};
+
+/*
+    Ricoh 2A03 of NES, Decimal flag is kept but has no effect
+*/
+struct Ricoh
+{
+    static constexpr bool decimal = false;
+    static constexpr bool cmos    = false;
+};
+
+/*
+    CMOS 65C02, base instruction set without Rockwell and WDC bit
+    instructions. Undefined operation codes are NOPs, JMP ($xxFF)
+    reads next page and decimal mode sets N and Z by its result
+*/
+struct Cmos
+{
+    static constexpr bool decimal = true;
+    static constexpr bool cmos    = true;
+};
+
+#if defined(CPU_2A03)
+using Variant = Ricoh;
+#elif defined(CPU_65C02)
+using Variant = Cmos;
+#else
+using Variant = Nmos;
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "trace/record.h"
+
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+/*
+    Records read per file call
+*/
+static const size_t batch = 4096;
+
+/*
+    Print binary trace file in disassembly format
+*/
+int main(int argc, char** argv)
+{
+    CLI::App app {"MOS 6502 binary trace disassembler"};
+
+    std::string path;
+
+    app.add_option ("file", path, "Binary trace file")
+        -> required();
+
+    try {
+        app.parse(argc, argv);
+    }
+    catch(const CLI::ParseError & e) {
+        return app.exit(e);
+    }
+
+    auto file = std::fopen(path.c_str(), "rb");
+
+    if (file == nullptr)
+    {
+        std::cerr << "File not found " << path;
+        return EXIT_FAILURE;
+    }
+
+    Header expected;
+    Header header;
+
+    if (std::fread(&header, sizeof(Header), 1, file) != 1 ||
+        std::memcmp(&header, &expected, sizeof(Header)) != 0)
+    {
+        std::cerr << "Unsupported trace file " << path;
+        std::fclose(file);
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Record> records(batch);
+    size_t count;
+
+    while ((count = std::fread(records.data(), sizeof(Record), batch, file)) > 0)
+    {
+        for (size_t i = 0; i < count; i++) {
+            Log::step(records[i]);
+        }
+    }
+
+    std::fclose(file);
+}
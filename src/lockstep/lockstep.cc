@@ -0,0 +1,757 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "lockstep.h"
+
+#include "cpu/cmd.h"
+
+#include "cpu/cpu.h"
+#include "cpu/map.h"
+#include "cpu/mem.h"
+#include "cpu/variant.h"
+#include "bus/bus.h"
+
+
+/*
+    Returns lane kind of every operation code
+    Built from opcode table at compile time
+*/
+constexpr std::array<Lockstep::Kind, 256> Lockstep::classify()
+{
+    using Code = void (Cpu::*) (void);
+    std::array<Kind, 256> kinds {};
+
+    for (std::size_t opcode = 0; opcode < kinds.size(); opcode++)
+    {
+        auto & oper = Map::getCommand((uint8_t) opcode);
+        auto & kind = kinds[opcode];
+
+        if      (oper.mode == &Cpu::IMP)  kind.mode = Mode::Imp;
+        else if (oper.mode == &Cpu::ACC)  kind.mode = Mode::Imp;
+        else if (oper.mode == &Cpu::IMM)  kind.mode = Mode::Imm;
+        else if (oper.mode == &Cpu::ZPG)  kind.mode = Mode::Zpg;
+        else if (oper.mode == &Cpu::ZPGX) kind.mode = Mode::Zpgx;
+        else if (oper.mode == &Cpu::ZPGY) kind.mode = Mode::Zpgy;
+        else if (oper.mode == &Cpu::ABS)  kind.mode = Mode::Abs;
+        else if (oper.mode == &Cpu::ABSX) kind.mode = Mode::Absx;
+        else if (oper.mode == &Cpu::ABSY) kind.mode = Mode::Absy;
+        else if (oper.mode == &Cpu::INDX) kind.mode = Mode::Indx;
+        else if (oper.mode == &Cpu::INDY) kind.mode = Mode::Indy;
+        else if (oper.mode == &Cpu::REL)  kind.mode = Mode::Rel;
+        else continue;
+
+        auto memory = kind.mode != Mode::Imp && kind.mode != Mode::Rel;
+
+        if      (oper.code == &Cpu::LDA && memory) kind.op = Op::LDA;
+        else if (oper.code == &Cpu::LDX && memory) kind.op = Op::LDX;
+        else if (oper.code == &Cpu::LDY && memory) kind.op = Op::LDY;
+        else if (oper.code == &Cpu::STA && memory) kind.op = Op::STA;
+        else if (oper.code == &Cpu::STX && memory) kind.op = Op::STX;
+        else if (oper.code == &Cpu::STY && memory) kind.op = Op::STY;
+        else if (oper.code == static_cast<Code>(&Cpu::ADC) && memory) kind.op = Op::ADC;
+        else if (oper.code == &Cpu::SBC && memory) kind.op = Op::SBC;
+        else if (oper.code == &Cpu::AND && memory) kind.op = Op::AND;
+        else if (oper.code == &Cpu::ORA && memory) kind.op = Op::ORA;
+        else if (oper.code == &Cpu::EOR && memory) kind.op = Op::EOR;
+        else if (oper.code == static_cast<Code>(&Cpu::CMP) && memory) kind.op = Op::CMP;
+        else if (oper.code == &Cpu::CPX && memory) kind.op = Op::CPX;
+        else if (oper.code == &Cpu::CPY && memory) kind.op = Op::CPY;
+        else if (oper.code == &Cpu::INC && memory) kind.op = Op::INC;
+        else if (oper.code == &Cpu::DEC && memory) kind.op = Op::DEC;
+        else if (oper.code == &Cpu::JMP && oper.mode == &Cpu::ABS) kind.op = Op::JMP;
+        else if (oper.code == &Cpu::TAX) kind.op = Op::TAX;
+        else if (oper.code == &Cpu::TAY) kind.op = Op::TAY;
+        else if (oper.code == &Cpu::TXA) kind.op = Op::TXA;
+        else if (oper.code == &Cpu::TYA) kind.op = Op::TYA;
+        else if (oper.code == &Cpu::TSX) kind.op = Op::TSX;
+        else if (oper.code == &Cpu::TXS) kind.op = Op::TXS;
+        else if (oper.code == &Cpu::INX) kind.op = Op::INX;
+        else if (oper.code == &Cpu::INY) kind.op = Op::INY;
+        else if (oper.code == &Cpu::DEX) kind.op = Op::DEX;
+        else if (oper.code == &Cpu::DEY) kind.op = Op::DEY;
+        else if (oper.code == &Cpu::CLC) kind.op = Op::CLC;
+        else if (oper.code == &Cpu::SEC) kind.op = Op::SEC;
+        else if (oper.code == &Cpu::CLV) kind.op = Op::CLV;
+        else if (oper.code == &Cpu::CLD) kind.op = Op::CLD;
+        else if (oper.code == &Cpu::SED) kind.op = Op::SED;
+        else if (oper.code == &Cpu::NOP) kind.op = Op::NOP;
+        else if (oper.code == &Cpu::ASL<Cpu::Accumulator>) kind.op = Op::ASL;
+        else if (oper.code == &Cpu::LSR<Cpu::Accumulator>) kind.op = Op::LSR;
+        else if (oper.code == &Cpu::ROL<Cpu::Accumulator>) kind.op = Op::ROL;
+        else if (oper.code == &Cpu::ROR<Cpu::Accumulator>) kind.op = Op::ROR;
+        else if (oper.code == &Cpu::ASL<Cpu::Memory> && memory) kind.op = Op::ASL;
+        else if (oper.code == &Cpu::LSR<Cpu::Memory> && memory) kind.op = Op::LSR;
+        else if (oper.code == &Cpu::ROL<Cpu::Memory> && memory) kind.op = Op::ROL;
+        else if (oper.code == &Cpu::ROR<Cpu::Memory> && memory) kind.op = Op::ROR;
+        else if (oper.code == &Cpu::BCC) kind.op = Op::BCC;
+        else if (oper.code == &Cpu::BCS) kind.op = Op::BCS;
+        else if (oper.code == &Cpu::BEQ) kind.op = Op::BEQ;
+        else if (oper.code == &Cpu::BNE) kind.op = Op::BNE;
+        else if (oper.code == &Cpu::BMI) kind.op = Op::BMI;
+        else if (oper.code == &Cpu::BPL) kind.op = Op::BPL;
+        else if (oper.code == &Cpu::BVC) kind.op = Op::BVC;
+        else if (oper.code == &Cpu::BVS) kind.op = Op::BVS;
+
+        // Undocumented commands only address operand on Cpu
+        else if (oper.code == &Cpu::SLO || oper.code == &Cpu::RLA || oper.code == &Cpu::SRE 
+              || oper.code == &Cpu::RRA || oper.code == &Cpu::SAX || oper.code == &Cpu::LAX 
+              || oper.code == &Cpu::DCP || oper.code == &Cpu::ISC || oper.code == &Cpu::ANC 
+              || oper.code == &Cpu::ALR || oper.code == &Cpu::ARR || oper.code == &Cpu::ANE 
+              || oper.code == &Cpu::LXA || oper.code == &Cpu::SBX || oper.code == &Cpu::LAS 
+              || oper.code == &Cpu::SHA || oper.code == &Cpu::SHX || oper.code == &Cpu::SHY 
+              || oper.code == &Cpu::TAS) kind.op = Op::NOP;
+    }
+
+    return kinds;
+}
+
+
+/*
+    Lane kind of every operation code
+*/
+const std::array<Lockstep::Kind, 256> Lockstep::kinds = Lockstep::classify();
+
+
+/*
+    Take registers of machines
+*/
+Lockstep::Lockstep(const std::vector<Cpu *> & machines) : lanes(machines.size())
+{
+    if (lanes > width) {
+        throw std::invalid_argument("Too many lockstep lanes");
+    }
+
+    for (std::size_t lane = 0; lane < lanes; lane++)
+    {
+        cpus[lane]  = machines[lane];
+        buses[lane] = &machines[lane] -> mem.getBus();
+    }
+}
+
+
+/*
+    Copy registers from Cpu to lane
+*/
+void Lockstep::load(std::size_t lane)
+{
+    auto & cpu = *cpus[lane];
+    uint8_t p = cpu.p;
+
+    a[lane] = cpu.a;
+    x[lane] = cpu.x;
+    y[lane] = cpu.y;
+    s[lane] = cpu.s;
+
+    n[lane] = p & 0x80;
+    z[lane] = !(p & 0x02);
+    c[lane] = p & 0x01;
+    v[lane] = (p >> 6) & 0x01;
+    f[lane] = p & 0x0C;
+
+    pc[lane] = cpu.pc;
+    cycles[lane]  = cpu.cycles;
+    counter[lane] = cpu.counter;
+}
+
+
+/*
+    Copy registers from lane to Cpu
+*/
+void Lockstep::store(std::size_t lane)
+{
+    auto & cpu = *cpus[lane];
+
+    cpu.a = a[lane];
+    cpu.x = x[lane];
+    cpu.y = y[lane];
+    cpu.s = s[lane];
+
+    cpu.p = f[lane] 
+        | (n[lane] & 0x80) 
+        | (z[lane] == 0 ? 0x02 : 0) 
+        | c[lane] 
+        | (v[lane] << 6);
+
+    // Break flag exists only on stack
+    cpu.p.setBreak(false);
+
+    cpu.pc = pc[lane];
+    cpu.cycles  = cycles[lane];
+    cpu.counter = counter[lane];
+}
+
+
+/*
+    Lane loops
+
+    Each loop runs over all lanes, active or not, so it has fixed
+    trip count and no branches and is vectorized. Inactive lanes
+    compute garbage which is never stored
+*/
+
+#define LANES for (std::size_t i = 0; i < width; i++)
+
+
+/*
+    Drop lane and hand its registers back to Cpu
+*/
+void Lockstep::drop(std::size_t lane)
+{
+    store(lane);
+    active[lane] = false;
+}
+
+
+/*
+    Returns true if page has same code on every active lane
+    Lane memory of page is kept in text until write to it
+*/
+bool Lockstep::same(uint8_t page, std::size_t leader)
+{
+    if (page == code)
+        return true;
+
+    if (page == mismatch)
+        return false;
+
+    for (std::size_t lane = 0; lane < lanes; lane++)
+    {
+        if (!active[lane])
+            continue;
+
+        text[lane] = buses[lane] -> getDirect(page << 8);
+
+        // Shared frame is same memory on both lanes
+        auto equal = text[lane] == text[leader] 
+            || (text[lane] != nullptr && std::memcmp(text[lane], text[leader], 0x100) == 0);
+
+        if (text[lane] == nullptr || !equal) 
+        {
+            code = none;
+            mismatch = page;
+
+            return false;
+        }
+    }
+
+    code = page;
+    return true;
+}
+
+
+/*
+    Drop finished and diverged lanes
+    Command bytes are read on leader only if its page has same code
+    on every lane, else operation code is compared lane by lane
+*/
+std::size_t Lockstep::converge()
+{
+    auto leader = width;
+
+    // Interrupts, traps and breakpoints are handled by scalar Cpu
+    for (std::size_t lane = 0; lane < lanes && leader == width; lane++)
+    {
+        if (!active[lane])
+            continue;
+
+        auto & bus = *buses[lane];
+        auto stop = bus.hasBreakpoints() && bus.isBreakpoint(pc[lane]);
+
+        if (cycles[lane] >= horizon[lane] || stop || cpus[lane] -> events) {
+            drop(lane);
+        } else {
+            leader = lane;
+        }
+    }
+
+    if (leader == width)
+        return width;
+
+    auto at = pc[leader];
+
+    // Lane left on other address continues alone
+    uint8_t done [width];
+    LANES { done[i] = (cycles[i] >= horizon[i]) | (pc[i] != at); }
+
+    for (std::size_t lane = leader + 1; lane < lanes; lane++)
+    {
+        if (!active[lane])
+            continue;
+
+        auto & bus = *buses[lane];
+        auto stop = bus.hasBreakpoints() && bus.isBreakpoint(pc[lane]);
+
+        if (done[lane] || stop || cpus[lane] -> events) {
+            drop(lane);
+        }
+    }
+
+    // Command of up to three bytes stays on page
+    if ((at & 0xFF) <= 0xFD && same(at >> 8, leader))
+    {
+        command = text[leader] + (at & 0xFF);
+        opcode  = command[0];
+
+        return leader;
+    }
+
+    command = nullptr;
+    opcode  = buses[leader] -> read(at);
+
+    // Lane left on other operation code continues alone
+    for (std::size_t lane = leader + 1; lane < lanes; lane++)
+    {
+        if (active[lane] && buses[lane] -> read(pc[lane]) != opcode) {
+            drop(lane);
+        }
+    }
+
+    return leader;
+}
+
+
+/*
+    Compute operand address and value of every active lane
+    Value is not read for store commands
+*/
+void Lockstep::operand(Mode mode, bool fetch)
+{
+    auto absolute = mode == Mode::Abs || mode == Mode::Absx || mode == Mode::Absy;
+
+    // Immediate operand is not read if command has no use for it
+    if (mode == Mode::Imm && !fetch)
+    {
+        LANES { address[i] = pc[i] + 1; }
+        return;
+    }
+
+    uint8_t lo [width] {};
+    uint8_t hi [width] {};
+
+    if (command != nullptr)
+    {
+        // Operand bytes are same on every lane
+        uint8_t low  = command[1];
+        uint8_t high = absolute ? command[2] : 0;
+
+        LANES { lo[i] = low; hi[i] = high; }
+    }
+    else
+    {
+        for (std::size_t lane = 0; lane < lanes; lane++)
+        {
+            if (!active[lane])
+                continue;
+
+            lo[lane] = buses[lane] -> read(pc[lane] + 1);
+
+            if (absolute) {
+                hi[lane] = buses[lane] -> read(pc[lane] + 2);
+            }
+        }
+    }
+
+    // Indirect modes read pointer on zeropage, X is added before
+    if (mode == Mode::Indx || mode == Mode::Indy)
+    {
+        for (std::size_t lane = 0; lane < lanes; lane++)
+        {
+            if (!active[lane])
+                continue;
+
+            uint8_t at = lo[lane] + (mode == Mode::Indx ? x[lane] : 0);
+
+            lo[lane] = buses[lane] -> read(at);
+            hi[lane] = buses[lane] -> read(0x00FF & (at + 1));
+        }
+    }
+
+    static const uint8_t zero [width] {};
+    const uint8_t * index = mode == Mode::Zpgx || mode == Mode::Absx ? x
+                          : mode == Mode::Zpgy || mode == Mode::Absy || mode == Mode::Indy ? y : zero;
+
+    switch (mode)
+    {
+        // Immediate value and branch offset are operand byte itself
+        case Mode::Imm:
+        case Mode::Rel:  
+            LANES { address[i] = pc[i] + 1; m[i] = lo[i]; } 
+            return;
+
+        case Mode::Zpg:
+        case Mode::Zpgx:
+        case Mode::Zpgy: 
+            LANES { address[i] = 0x00FF & (lo[i] + index[i]); } 
+            break;
+
+        case Mode::Abs:
+        case Mode::Absx:
+        case Mode::Absy:
+        case Mode::Indx:
+        case Mode::Indy:
+            LANES 
+            {
+                uint16_t base = lo[i] | (hi[i] << 8);
+
+                address[i] = base + index[i];
+                cross[i] = Mem::crossed(base, address[i]);
+            }
+            break;
+
+        case Mode::Imp: 
+            return;
+    }
+
+    if (fetch)
+    {
+        for (std::size_t lane = 0; lane < lanes; lane++) 
+        {
+            if (active[lane]) {
+                m[lane] = buses[lane] -> read(address[lane]);
+            }
+        }
+    }
+}
+
+
+/*
+    Execute instructions on scalar Cpu of every active lane up to
+    next command with lane implementation, so registers are copied
+    once for a run of such commands
+*/
+void Lockstep::scalar()
+{
+    auto first = true;
+
+    for (std::size_t lane = 0; lane < lanes; lane++)
+    {
+        if (!active[lane])
+            continue;
+
+        auto & cpu = *cpus[lane];
+        auto & bus = *buses[lane];
+
+        store(lane);
+
+        do 
+        {
+            cpu.step();
+            scalarSteps += first;
+        } 
+        while (cpu.cycles < horizon[lane] && !cpu.events 
+            && kinds[bus.peek(cpu.pc)].op == Op::None
+            && !(bus.hasBreakpoints() && bus.isBreakpoint(cpu.pc)));
+
+        load(lane);
+        first = false;
+    }
+
+    // Scalar commands may write code
+    code = none;
+}
+
+
+/*
+    Execute instruction in every lane
+*/
+bool Lockstep::vector(uint8_t opcode)
+{
+    auto kind = kinds[opcode];
+
+    if (kind.op == Op::None)
+        return false;
+
+    // Decimal ADC and SBC are left to scalar Cpu
+    if constexpr (Variant::decimal) 
+    {
+        if (kind.op == Op::ADC || kind.op == Op::SBC) 
+        {
+            uint8_t decimal = 0;
+            LANES { decimal |= active[i] ? f[i] : 0; }
+
+            if (decimal & 0x08)
+                return false;
+        }
+    }
+
+    auto & oper = Map::getCommand(opcode);
+    auto bytes  = oper.getBytes();
+
+    auto store  = kind.op == Op::STA || kind.op == Op::STX || kind.op == Op::STY;
+    auto shift  = kind.op == Op::ASL || kind.op == Op::LSR || kind.op == Op::ROL || kind.op == Op::ROR;
+    auto branch = kind.mode == Mode::Rel;
+
+    // Read-modify-write commands write result back to operand address
+    auto accumulator = shift && kind.mode == Mode::Imp;
+    auto modify = kind.op == Op::INC || kind.op == Op::DEC || (shift && !accumulator);
+
+    if (kind.mode != Mode::Imp) {
+        operand(kind.mode, !store && kind.op != Op::JMP && kind.op != Op::NOP);
+    }
+
+    if (accumulator) {
+        LANES { m[i] = a[i]; }
+    }
+
+    // Jump or branch to itself is left to scalar Cpu, which raises trap
+    if (branch || kind.op == Op::JMP)
+    {
+        uint8_t trap = 0;
+
+        LANES 
+        {
+            uint16_t target = branch ? pc[i] + 2 + (int8_t) m[i] : address[i];
+            trap |= active[i] & trapping[i] & (target == pc[i]);
+        }
+
+        if (trap)
+            return false;
+    }
+
+    // Flag tested by branch, taken when it matches
+    const uint8_t * flag = nullptr;
+    uint8_t match = 0;
+
+    uint8_t r [width];
+
+    switch (kind.op)
+    {
+        case Op::LDA: LANES { a[i] = m[i]; n[i] = z[i] = a[i]; } break;
+        case Op::LDX: LANES { x[i] = m[i]; n[i] = z[i] = x[i]; } break;
+        case Op::LDY: LANES { y[i] = m[i]; n[i] = z[i] = y[i]; } break;
+
+        case Op::STA: LANES { r[i] = a[i]; } break;
+        case Op::STX: LANES { r[i] = x[i]; } break;
+        case Op::STY: LANES { r[i] = y[i]; } break;
+
+        case Op::SBC: 
+            LANES { m[i] = ~m[i]; } 
+            [[fallthrough]];
+
+        case Op::ADC: 
+            LANES 
+            {
+                uint16_t sum = a[i] + m[i] + c[i];
+
+                v[i] = (~(a[i] ^ m[i]) & (a[i] ^ sum) & 0x80) != 0;
+                c[i] = sum > 0xFF;
+                a[i] = (uint8_t) sum;
+                n[i] = z[i] = a[i];
+            }
+            break;
+
+        case Op::AND: LANES { a[i] &= m[i]; n[i] = z[i] = a[i]; } break;
+        case Op::ORA: LANES { a[i] |= m[i]; n[i] = z[i] = a[i]; } break;
+        case Op::EOR: LANES { a[i] ^= m[i]; n[i] = z[i] = a[i]; } break;
+
+        // Same flags as scalar CMP
+        case Op::CMP: LANES { r[i] = a[i]; } goto compare;
+        case Op::CPX: LANES { r[i] = x[i]; } goto compare;
+        case Op::CPY: LANES { r[i] = y[i]; } goto compare;
+
+        compare:
+            LANES 
+            {
+                n[i] = m[i] >  r[i] ? 0x80 : 0x00;
+                z[i] = m[i] != r[i];
+                c[i] = m[i] <= r[i];
+            }
+            break;
+
+        case Op::INC: LANES { r[i] = m[i] + 1; n[i] = z[i] = r[i]; } break;
+        case Op::DEC: LANES { r[i] = m[i] - 1; n[i] = z[i] = r[i]; } break;
+
+        case Op::TAX: LANES { x[i] = a[i]; n[i] = z[i] = x[i]; } break;
+        case Op::TAY: LANES { y[i] = a[i]; n[i] = z[i] = y[i]; } break;
+        case Op::TXA: LANES { a[i] = x[i]; n[i] = z[i] = a[i]; } break;
+        case Op::TYA: LANES { a[i] = y[i]; n[i] = z[i] = a[i]; } break;
+        case Op::TSX: LANES { x[i] = s[i]; n[i] = z[i] = x[i]; } break;
+        case Op::TXS: LANES { s[i] = x[i]; } break;
+
+        case Op::INX: LANES { x[i]++; n[i] = z[i] = x[i]; } break;
+        case Op::INY: LANES { y[i]++; n[i] = z[i] = y[i]; } break;
+        case Op::DEX: LANES { x[i]--; n[i] = z[i] = x[i]; } break;
+        case Op::DEY: LANES { y[i]--; n[i] = z[i] = y[i]; } break;
+
+        case Op::CLC: LANES { c[i] = 0; } break;
+        case Op::SEC: LANES { c[i] = 1; } break;
+        case Op::CLV: LANES { v[i] = 0; } break;
+        case Op::CLD: LANES { f[i] &= ~0x08; } break;
+        case Op::SED: LANES { f[i] |=  0x08; } break;
+        case Op::NOP: break;
+
+        // Shifted value is accumulator or memory operand
+        case Op::ASL: LANES { c[i] = m[i] >> 7;   r[i] = m[i] << 1; n[i] = z[i] = r[i]; } break;
+        case Op::LSR: LANES { c[i] = m[i] & 0x01; r[i] = m[i] >> 1; n[i] = z[i] = r[i]; } break;
+
+        case Op::ROL: 
+            LANES 
+            { 
+                uint8_t carry = m[i] >> 7;
+                r[i] = (m[i] << 1) | c[i]; 
+                c[i] = carry;
+                n[i] = z[i] = r[i]; 
+            } 
+            break;
+
+        case Op::ROR: 
+            LANES 
+            { 
+                uint8_t carry = m[i] & 0x01;
+                r[i] = (m[i] >> 1) | (c[i] << 7); 
+                c[i] = carry;
+                n[i] = z[i] = r[i]; 
+            } 
+            break;
+
+        // Zero flag is set when z is zero, negative when bit 7 of n is
+        case Op::BCC: flag = c; match = 0; break;
+        case Op::BCS: flag = c; match = 1; break;
+        case Op::BNE: flag = z; match = 1; break;
+        case Op::BEQ: flag = z; match = 0; break;
+        case Op::BPL: flag = n; match = 0; break;
+        case Op::BMI: flag = n; match = 1; break;
+        case Op::BVC: flag = v; match = 0; break;
+        case Op::BVS: flag = v; match = 1; break;
+
+        case Op::JMP: break;
+        case Op::None: break;
+    }
+
+    if (accumulator) {
+        LANES { a[i] = r[i]; }
+    }
+
+    if (store || modify)
+    {
+        auto written = false;
+
+        for (std::size_t lane = 0; lane < lanes; lane++) 
+        {
+            if (!active[lane])
+                continue;
+
+            // Write to shared page replaces its memory, so it is compared before
+            written |= buses[lane] -> getDirect(address[lane]) == text[lane];
+            buses[lane] -> write(address[lane], r[lane]);
+        }
+
+        if (written) {
+            code = none;
+        }
+    }
+
+    if (branch)
+    {
+        LANES 
+        {
+            uint16_t next = pc[i] + 2;
+            uint16_t target = next + (int8_t) m[i];
+
+            uint8_t test  = flag == n ? (flag[i] >> 7) : (flag[i] != 0);
+            uint8_t taken = test == match;
+
+            pc[i] = taken ? target : next;
+            cycles[i] += oper.cycles + taken * (1 + Mem::crossed(next, target));
+        }
+    }
+    else if (kind.op == Op::JMP)
+    {
+        LANES { pc[i] = address[i]; cycles[i] += oper.cycles; }
+    }
+    else
+    {
+        LANES 
+        { 
+            pc[i] += bytes; 
+            cycles[i] += oper.cycles + (cross[i] & oper.penalty); 
+        }
+    }
+
+    LANES { counter[i]++; }
+
+    vectorSteps++;
+    return true;
+}
+
+#undef LANES
+
+
+/*
+    Run every machine for cycle budget
+*/
+void Lockstep::run(uint64_t budget)
+{
+    for (std::size_t lane = 0; lane < lanes; lane++)
+    {
+        load(lane);
+
+        active[lane]   = true;
+        trapping[lane] = cpus[lane] -> trapping;
+        until[lane]  = cycles[lane] + budget;
+
+        // Device events are dispatched by scalar Cpu
+        horizon[lane] = std::min(until[lane], buses[lane] -> getScheduler().next());
+    }
+
+    // Memory may have changed since last run
+    code = none;
+    mismatch = none;
+
+    while (converge() < width)
+    {
+        if (!vector(opcode)) {
+            scalar();
+        }
+    }
+
+    // Diverged lanes finish on scalar Cpu, lanes stopped by
+    // breakpoint, watchpoint, trap or halt keep their event
+    for (std::size_t lane = 0; lane < lanes; lane++)
+    {
+        auto & cpu = *cpus[lane];
+
+        if (cpu.events & (Cpu::Event::Break | Cpu::Event::Trap | Cpu::Event::Halt))
+            continue;
+
+        if (cpu.cycles < until[lane]) {
+            cpu.run(until[lane] - cpu.cycles);
+        }
+    }
+}
+
+
+/*
+    Returns instructions executed for all lanes at once
+*/
+uint64_t Lockstep::getVectorSteps() const
+{
+    return vectorSteps;
+}
+
+
+/*
+    Returns instructions executed on scalar Cpu of all lanes
+*/
+uint64_t Lockstep::getScalarSteps() const
+{
+    return scalarSteps;
+}
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Bus;
+class Cpu;
+
+//
+// Lockstep engine (experimental)
+//
+// Runs up to 16 machines executing same code at once. Registers
+// of all machines are kept as structure of arrays, one lane per
+// machine, and common instruction is executed for every lane by
+// plain loops over lanes, which compiler turns into SIMD code.
+// Memory stays per machine, operands are gathered lane by lane.
+//
+// Lane which reaches other address or operation code than first
+// lane leaves lockstep and continues on its scalar Cpu. Commands
+// without lane implementation run on scalar Cpu of every lane up
+// to next command with one
+//
+
+class Lockstep
+{
+public:
+
+    static constexpr std::size_t width = 16;
+
+private:
+
+    //
+    // Lane kinds of supported commands
+    //
+
+    enum class Op : uint8_t
+    {
+        None, 
+        LDA, LDX, LDY, STA, STX, STY, 
+        ADC, SBC, AND, ORA, EOR, CMP, CPX, CPY, INC, DEC,
+        TAX, TAY, TXA, TYA, TSX, TXS, INX, INY, DEX, DEY,
+        CLC, SEC, CLV, CLD, SED, NOP, ASL, LSR, ROL, ROR,
+        BCC, BCS, BEQ, BNE, BMI, BPL, BVC, BVS, JMP
+    };
+
+    enum class Mode : uint8_t
+    {
+        Imp, Imm, Zpg, Zpgx, Zpgy, Abs, Absx, Absy, Indx, Indy, Rel
+    };
+
+    struct Kind
+    {
+        Op op = Op::None;
+        Mode mode = Mode::Imp;
+    };
+
+    /*
+        Returns lane kind of every operation code
+    */
+    static constexpr std::array<Kind, 256> classify();
+
+    /*
+        Lane kind of every operation code
+    */
+    static const std::array<Kind, 256> kinds;
+
+    /*
+        Lane registers
+        Flags are kept lazily like in Status
+    */
+    uint8_t a [width] {};
+    uint8_t x [width] {};
+    uint8_t y [width] {};
+    uint8_t s [width] {};
+
+    uint8_t n [width] {}; // Negative is bit 7
+    uint8_t z [width] {}; // Zero when value is zero
+    uint8_t c [width] {}; // Carry, 0 or 1
+    uint8_t v [width] {}; // Overflow, 0 or 1
+    uint8_t f [width] {}; // Interrupt and Decimal flags
+
+    uint16_t pc [width] {};
+
+    uint64_t cycles  [width] {};
+    uint64_t until   [width] {};
+    uint64_t horizon [width] {}; // Earliest of until and next device event
+    uint64_t counter [width] {};
+
+    /*
+        Operand address, value and page cross of current instruction
+    */
+    uint16_t address [width] {};
+    uint8_t  m       [width] {};
+    uint8_t  cross   [width] {};
+
+    /*
+        Lanes still in lockstep
+    */
+    bool active [width] {};
+
+    /*
+        Trap detection of lane Cpu, fixed during run
+    */
+    uint8_t trapping [width] {};
+
+    /*
+        Operation code at program counter of every active lane
+    */
+    uint8_t opcode = 0;
+
+    /*
+        Page with same code on every active lane and its memory
+        on every lane, none until checked or after write to it
+    */
+    static constexpr uint16_t none = 0x100;
+
+    uint16_t code = none;
+    uint16_t mismatch = none;
+
+    const uint8_t * text [width] {};
+
+    /*
+        Command bytes of leader on page with same code, else null
+    */
+    const uint8_t * command = nullptr;
+
+    std::size_t lanes = 0;
+
+    Cpu * cpus  [width] {};
+    Bus * buses [width] {};
+
+    /*
+        Instructions executed by lanes or by scalar fallback
+    */
+    uint64_t vectorSteps = 0;
+    uint64_t scalarSteps = 0;
+
+    /*
+        Copy registers between Cpu and lane
+    */
+    void load  (std::size_t lane);
+    void store (std::size_t lane);
+
+    /*
+        Drop lane and hand its registers back to Cpu
+    */
+    void drop (std::size_t lane);
+
+    /*
+        Returns true if page has same code on every active lane
+    */
+    bool same (uint8_t page, std::size_t leader);
+
+    /*
+        Drop finished and diverged lanes
+        Returns first active lane or width if none left
+    */
+    std::size_t converge();
+
+    /*
+        Compute operand address and value of every active lane
+    */
+    void operand(Mode mode, bool fetch);
+
+    /*
+        Execute instruction in every lane
+        Returns false if command has no lane implementation
+    */
+    bool vector(uint8_t opcode);
+
+    /*
+        Execute instruction on scalar Cpu of every active lane
+    */
+    void scalar();
+
+public:
+
+    /*
+        Machines to run, at most width
+        Cpu objects must outlive Lockstep
+    */
+    Lockstep(const std::vector<Cpu *> & machines);
+
+    /*
+        Run every machine for cycle budget
+    */
+    void run(uint64_t budget);
+
+    /*
+        Returns instructions executed for all lanes at once
+    */
+    uint64_t getVectorSteps() const;
+
+    /*
+        Returns instructions executed on scalar Cpu of all lanes
+    */
+    uint64_t getScalarSteps() const;
+};
+
+#endif
@@ -15,11 +15,16 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstdio>
+#include <iterator>
+
 #include "log.h"
 
 #include "cpu/cpu.h"
 #include "cpu/cmd.h"
+#include "cpu/map.h"
 #include "bus/bus.h"
+#include "trace/record.h"
 
 #include "fmt/core.h"
 #include "fmt/color.h"
@@ -38,32 +43,37 @@ static const fmt::text_style light = fg(fmt::color::dark_gray);
 /*
     Default constructor
 */
-Log::Log(std::shared_ptr<Bus> bus) : bus(bus) 
+Log::Log(const Bus & bus) : bus(bus) 
 { }
 
 
 /*
     Disassembly operation and print details
 */
-void Log::step (uint32_t counter, uint16_t pc, const Cmd & cmd, const Cpu * cpu) const
+void Log::step (uint64_t counter, uint16_t pc, const Cmd & cmd, const Cpu * cpu) const
 {
-    fmt::print(dark, "{:06} ", counter);
+    fmt::memory_buffer out;
+    auto it = std::back_inserter(out);
+
+    fmt::format_to(it, dark, "{:06} ", counter);
 
     // Programm counter & Operation code
-    fmt::print(dark, "{:#06x} ", pc);
-    fmt::print(dark, "{:#04x} ", bus -> read(pc));
+    fmt::format_to(it, dark, "{:#06x} ", pc);
+
+    auto opcode = bus.peek(pc);
+    fmt::format_to(it, dark, "{:#04x} ", opcode);
 
     // Command name
-    fmt::print(code, "{} ", cmd.name);
+    fmt::format_to(it, code, "{} ", Map::getName(opcode));
 
     // Command arguments    
-    printArgs(pc, cmd.getBytes()); 
+    printArgs(out, pc, cmd.getBytes()); 
 
     // Print memory at argument
-    fmt::print(dark, "${:02X} ", bus -> read(cpu -> op));
+    fmt::format_to(it, dark, "${:02X} ", bus.peek(cpu -> op));
 
     // Registers
-    fmt::print(light, 
+    fmt::format_to(it, light, 
         "A:{:02X} X:{:02X} Y:{:02X} S:{:02X} ", 
             cpu -> a, 
             cpu -> x, 
@@ -72,13 +82,13 @@ void Log::step (uint32_t counter, uint16_t pc, const Cmd & cmd, const Cpu * cpu)
     );
 
     // Print memory at argument
-    fmt::print(light, "${:02X} ${:02X} ${:02X} ", 
-        bus -> read(0x0100 + cpu -> s - 1),
-        bus -> read(0x0100 + cpu -> s),
-        bus -> read(0x0100 + cpu -> s + 1));
+    fmt::format_to(it, light, "${:02X} ${:02X} ${:02X} ", 
+        bus.peek(0x0100 + cpu -> s - 1),
+        bus.peek(0x0100 + cpu -> s),
+        bus.peek(0x0100 + cpu -> s + 1));
 
     // Status register
-    fmt::print(dark, 
+    fmt::format_to(it, dark, 
         "N:{} V:{} -:{} B:{} D:{} I:{} Z:{} C:{}\n", 
             cpu -> p.getNegative(),
             cpu -> p.getOverflow(),
@@ -89,17 +99,76 @@ void Log::step (uint32_t counter, uint16_t pc, const Cmd & cmd, const Cpu * cpu)
             cpu -> p.getZero(),
             cpu -> p.getCarry()
     );
+
+    std::fwrite(out.data(), 1, out.size(), stdout);
+}
+
+
+/*
+    Disassembly recorded operation
+*/
+void Log::step (const Record & record)
+{
+    fmt::memory_buffer out;
+    auto it = std::back_inserter(out);
+
+    fmt::format_to(it, dark, "{:06} ", record.cycle);
+
+    // Programm counter & Operation code
+    fmt::format_to(it, dark, "{:#06x} ", record.pc);
+    fmt::format_to(it, dark, "{:#04x} ", record.opcode);
+
+    // Command name
+    fmt::format_to(it, code, "{} ", Map::getName(record.opcode));
+
+    // Command arguments
+    auto size = Map::getCommand(record.opcode).getBytes();
+
+    for (int i = 1; i < size; i++) {
+        fmt::format_to(it, light, "{:#04x} ", record.args[i - 1]);
+    }
+
+    fmt::format_to(it, "{:^{}}", "", (3 - size) * 5);
+
+    // Registers
+    fmt::format_to(it, light, 
+        "A:{:02X} X:{:02X} Y:{:02X} S:{:02X} ", 
+            record.a, 
+            record.x, 
+            record.y, 
+            record.s
+    );
+
+    // Status register, break flag exists only on stack
+    Status p = record.p;
+    p.setBreak(false);
+
+    fmt::format_to(it, dark, 
+        "N:{} V:{} -:{} B:{} D:{} I:{} Z:{} C:{}\n", 
+            p.getNegative(),
+            p.getOverflow(),
+            p.getDefault(),
+            p.getBreak(),
+            p.getDecimal(),
+            p.getInterrupt(),
+            p.getZero(),
+            p.getCarry()
+    );
+
+    std::fwrite(out.data(), 1, out.size(), stdout);
 }
 
 
 /*
     Pring command arguments
 */
-void Log::printArgs(uint16_t pc, uint8_t size) const
+void Log::printArgs(fmt::memory_buffer & out, uint16_t pc, uint8_t size) const
 {
+    auto it = std::back_inserter(out);
+
     for (int i = 1; i < size; i++) {
-        fmt::print(light, "{:#04x} ", bus -> read(++pc));
+        fmt::format_to(it, light, "{:#04x} ", bus.peek(++pc));
     }
 
-    fmt::print("{:^{}}", "", (3 - size) * 5);   
+    fmt::format_to(it, "{:^{}}", "", (3 - size) * 5);   
 }
\ No newline at end of file
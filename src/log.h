@@ -22,24 +22,35 @@
 #include <memory>
 #include <string>
 
+#include "fmt/format.h"
+
 class Cpu;
 class Bus; 
 class Cmd;
+struct Record;
 
 class Log
 {
 private:
-    std::shared_ptr<Bus> bus;
+    const Bus & bus;
     
-    void printArgs(uint16_t pc, uint8_t size) const;
+    void printArgs(fmt::memory_buffer & out, uint16_t pc, uint8_t size) const;
 
 public:
-    Log(std::shared_ptr<Bus> bus);
+    Log(const Bus & bus);
 
     /*
         Disassembly operation
+        Line is formatted in memory and written at once
+    */
+    void step (uint64_t counter, uint16_t pc, const Cmd & cmd, const Cpu * cpu) const;
+
+    /*
+        Disassembly recorded operation
+        Same format, cycle replaces counter and memory
+        columns are omitted as record has no bus access
     */
-    void step (uint32_t counter, uint16_t pc, const Cmd & cmd, const Cpu * cpu) const;
+    static void step (const Record & record);
 };
 
 #endif
\ No newline at end of file
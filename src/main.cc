@@ -15,14 +15,34 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <iostream>
-#include <fstream>
+#include <iterator>
+#include <thread>
+#include <limits>
+#include <vector>
 
-#include "log.h"
+#include "batch/batch.h"
+#include "cosim/cosim.h"
 
 #include "cpu/cpu.h"
 #include "bus/bus.h"
+#include "rom/rom.h"
+#include "movie/movie.h"
+#include "movie/player.h"
+#include "profile/profile.h"
+#include "rewind/rewind.h"
+#include "snapshot/snapshot.h"
+#include "stats/stats.h"
+#include "summary/summary.h"
+#include "trace/trace.h"
+#include "trace/recorder.h"
+
+#ifndef WIN32
+    #include "remote/server.h"
+#endif
 
 #include "fmt/core.h"
 #include "fmt/format.h"
@@ -35,61 +55,208 @@
 // Caption text style
 static const fmt::text_style caption = fg(fmt::color::dark_gray) | fmt::emphasis::underline;
 
-// Memory bus
-std::shared_ptr<Bus> bus = std::make_shared<Bus>();
+/*
+    Map ROM image to bus
+    Returned ROM must outlive bus use
+*/
+std::unique_ptr<Rom> load(const std::shared_ptr<Bus> & bus, const std::string & path)
+{
+    auto rom = std::make_unique<Rom>(path);
+    rom -> attach(*bus);
+
+    return rom;
+}
+
 
 /*
-    Load ROM to memory
+    Result record of quiet mode
 */
-void load(std::string path)
+struct Quiet
 {
-    std::ifstream file(path, std::ios::in | std::ios::binary);
+    bool enabled = false;
+    bool binary  = false;
 
-    if (!file.is_open())
-    {
-        std::cerr << "File not found " << path;
-        exit(EXIT_FAILURE);
-        
-        return;
-    }
-    
-    #ifdef WIN32
+    // Memory range is hashed, bytes are added on request
+    uint16_t from = 0x0000;
+    uint16_t to   = 0x00FF;
+    bool memory   = false;
+};
 
-        // ~
 
-    #else
-        file.read ( 
-            (std::ifstream::char_type *) bus -> begin(), 
-            (std::streamsize) bus -> size()
-        );
-    #endif
+/*
+    Write result records of quiet mode with one write
+    Counters are JSON text by record, or empty
+*/
+void summarize(const std::vector<Summary> & summaries, const std::vector<std::string> & stats, const Quiet & quiet)
+{
+    fmt::memory_buffer buffer;
 
-    file.close();
+    if (quiet.binary) {
+        Summary::header(buffer);
+    }
+
+    for (std::size_t index = 0; index < summaries.size(); index++)
+    {
+        if (quiet.binary) {
+            summaries[index].toBinary(buffer);
+        } else {
+            summaries[index].toJson(buffer, index < stats.size() ? stats[index] : "");
+        }
+    }
+
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
 }
 
 
 /*
-    Load ROM
+    Print counters as json or prometheus text
 */
-void load_rom(std::string rom)
+void report(const Stats & stats, const std::string & format)
 {
-    auto path = fmt::format("../ext/asm/bin_files/{}", rom);
-    load(path);
+    auto text = format == "json" ? stats.toJson() : stats.toPrometheus();
+    std::fwrite(text.data(), 1, text.size(), stdout);
 }
 
 
 /*
     Run CPU
 */
-void run(int cycles)
+void run(const std::shared_ptr<Bus> & bus, const Rom & rom, uint64_t cycles, Cpu::Backend backend, std::unique_ptr<Trace> trace, 
+         const std::string & file, const std::string & restore, const std::string & save,
+         std::unique_ptr<Profile> profile, std::size_t top, const std::string & stacks, bool trap,
+         uint64_t seek, uint64_t interval, std::size_t depth, const std::string & stats, uint16_t port,
+         const Quiet & quiet)
 {
-    auto log = std::make_shared<Log>(bus);
-    auto cpu = std::make_unique<Cpu>(bus);
+    auto cpu = std::make_unique<Cpu>(bus, backend);
+    rom.boot(*cpu);
+
+    if (!restore.empty()) {
+        Snapshot::load(restore).restore(*cpu);
+    }
+
+    std::unique_ptr<Recorder> recorder;
+
+    if (!file.empty())
+    {
+        recorder = std::make_unique<Recorder>(file);
+        cpu -> setRecorder(recorder.get());
+    }
+
+    cpu -> setTrace(std::move(trace));
+    cpu -> setProfile(profile.get());
+    cpu -> setTrapDetection(trap);
+
+    // Journal is recorded only when going back is requested
+    std::unique_ptr<Rewind> rewind;
+
+    if (seek != std::numeric_limits<uint64_t>::max()) {
+        rewind = std::make_unique<Rewind>(*cpu, interval, depth);
+    }
 
-    fmt::print(caption, "\nDissassembly\n\n");
+    if (!quiet.enabled) {
+        fmt::print(caption, "\nDissassembly\n\n");
+    }
         
-    while (cycles--) {
-        cpu -> clock();
+    if (port != 0) 
+    {
+        // Client drives run, starts it with resume
+        // Remote server is POSIX only, port stays zero elsewhere
+        #ifndef WIN32
+            Server server(*cpu, bus, port);
+            server.run(cycles);
+        #endif
+    } 
+    else if (rewind) {
+        rewind -> run(cycles);
+    } else {
+        cpu -> run(cycles);
+    }
+
+    // Rewind leaves run stop behind
+    auto stop = Summary::reason(*cpu);
+
+    if (!quiet.enabled && cpu -> isTrapped()) 
+    {
+        fmt::print(caption, "\n\nTrap\n");
+        fmt::print("\nPC:{:04X} after {} instructions, {} cycles\n", 
+            cpu -> getPc(), cpu -> getInstructions(), cpu -> getCycles());
+    }
+
+    if (!quiet.enabled && cpu -> isHalted()) 
+    {
+        fmt::print(caption, "\n\nHalt\n");
+        fmt::print("\nJAM at PC:{:04X} after {} instructions, {} cycles\n", 
+            cpu -> getPc(), cpu -> getInstructions(), cpu -> getCycles());
+    }
+
+    if (!quiet.enabled && cpu -> isBreak()) 
+    {
+        auto & hit = bus -> getHit();
+
+        auto access = hit.access == Bus::Access::Execute ? "Breakpoint" 
+                    : hit.access == Bus::Access::Write   ? "Write" : "Read";
+
+        fmt::print(caption, "\n\nBreak\n");
+        fmt::print("\n{} ${:04X} data ${:02X}, PC:{:04X} after {} instructions, {} cycles\n", 
+            access, hit.address, hit.data, cpu -> getPc(), cpu -> getInstructions(), cpu -> getCycles());
+    }
+
+    if (rewind && quiet.enabled) {
+        rewind -> seek(seek);
+    }
+    else if (rewind) 
+    {
+        fmt::print(caption, "\n\nRewind\n");
+
+        if (!rewind -> seek(seek)) {
+            fmt::print("\nInstruction {} is out of reach, oldest is {}\n", seek, rewind -> getOldest());
+        }
+
+        auto r = Snapshot::read(*cpu);
+
+        fmt::print("\nPC:{:04X} A:{:02X} X:{:02X} Y:{:02X} S:{:02X} P:{:02X} after {} instructions, {} cycles\n",
+            r.pc, r.a, r.x, r.y, r.s, r.p, r.instructions, r.cycles);
+    }
+
+    if (profile) 
+    {
+        if (!quiet.enabled) 
+        {
+            fmt::print(caption, "\n\nProfile\n");
+            profile -> printHot(stdout, top);
+        }
+
+        if (!stacks.empty()) {
+            profile -> saveStacks(stacks);
+        }
+    }
+
+    if (!stats.empty() && !quiet.enabled) 
+    {
+        fmt::print(caption, "\n\nStats\n\n");
+        report(cpu -> getStats(), stats);
+    }
+
+    if (recorder && recorder -> getDropped() > 0) {
+        std::cerr << "Trace records dropped " << recorder -> getDropped() << '\n';
+    }
+
+    if (!save.empty()) {
+        Snapshot(*cpu).save(save);
+    }
+
+    if (quiet.enabled) 
+    {
+        auto summary = Summary::read(*cpu, *bus, quiet.from, quiet.to, quiet.memory);
+        summary.stop = stop;
+
+        std::vector<std::string> counters;
+
+        if (!stats.empty()) {
+            counters.push_back(cpu -> getStats().toJson());
+        }
+
+        summarize({ summary }, counters, quiet);
     }
 }
 
@@ -97,7 +264,7 @@ void run(int cycles)
 /*
     Print memory dump
 */
-void dump(uint16_t from, uint16_t to)
+void dump(const std::shared_ptr<Bus> & bus, uint16_t from, uint16_t to)
 {
     fmt::print(caption, "\n\nMemory dump from {:#04x} to {:#04x}\n", 0x00, 0xFF);
 
@@ -105,6 +272,203 @@ void dump(uint16_t from, uint16_t to)
     fmt::print("\n\n");
 }
 
+/*
+    Run batch of machines and print result of each one
+    Output is formatted after all workers are finished
+*/
+void batch(const std::string & path, uint64_t cycles, Cpu::Backend backend, std::size_t threads, const std::string & stats,
+           const Quiet & quiet)
+{
+    auto jobs = Batch::parse(path, cycles, backend, quiet.from, quiet.to, quiet.memory);
+
+    auto beg = std::chrono::steady_clock::now();
+    auto results = jobs.run(threads);
+    auto end = std::chrono::steady_clock::now();
+
+    // One record by machine in job order
+    if (quiet.enabled) 
+    {
+        std::vector<Summary> summaries;
+        std::vector<std::string> counters;
+
+        for (auto & result : results) 
+        {
+            summaries.push_back(result.summary);
+
+            if (!stats.empty()) {
+                counters.push_back(result.error.empty() ? result.stats.toJson() : "");
+            }
+        }
+
+        summarize(summaries, counters, quiet);
+        return;
+    }
+
+    std::chrono::duration<double> elapsed = end - beg;
+
+    fmt::memory_buffer buffer;
+    auto it = std::back_inserter(buffer);
+
+    uint64_t instructions = 0;
+    Stats total;
+
+    for (std::size_t index = 0; index < results.size(); index++)
+    {
+        auto & result = results[index];
+
+        if (!result.error.empty()) 
+        {
+            fmt::format_to(it, "{:>6} error {}\n", index, result.error);
+            continue;
+        }
+
+        auto & r = result.registers;
+
+        fmt::format_to(it, 
+            "{:>6} PC:{:04X} A:{:02X} X:{:02X} Y:{:02X} S:{:02X} P:{:02X} {:>12} instr {:>12} cycles {:>12.0f} instr/s\n",
+            index, r.pc, r.a, r.x, r.y, r.s, r.p, 
+            result.instructions, result.cycles, result.instructions / result.seconds);
+
+        instructions += result.instructions;
+        total += result.stats;
+    }
+
+    fmt::format_to(it, "{} machines, {} threads, {:.0f} instr/s aggregate\n", 
+        results.size(), threads, instructions / elapsed.count());
+
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+
+    if (!stats.empty()) {
+        report(total, stats);
+    }
+}
+
+
+/*
+    Run backend against table backend and print result
+    Returns false on divergence
+*/
+bool cosim(const std::string & rom, uint64_t cycles, Cpu::Backend backend, uint64_t interval, const std::string & restore)
+{
+    Cosim simulation(rom, Cpu::Backend::Table, backend, restore);
+
+    fmt::print(caption, "\nCo-simulation\n\n");
+
+    if (!simulation.run(cycles, interval))
+        return false;
+
+    fmt::print("{} checks passed, {} instructions, {} cycles\n", simulation.getChecks(),
+        simulation.getReference().getInstructions(), simulation.getReference().getCycles());
+
+    return true;
+}
+
+
+/*
+    Record movie of run and print memory dump
+*/
+void record(const std::string & rom, uint64_t cycles, Cpu::Backend backend, const std::string & path, 
+            const std::string & inputs, uint32_t period, uint64_t interval, const std::string & restore,
+            const Quiet & quiet)
+{
+    Player player(rom, backend, period);
+
+    if (!restore.empty()) {
+        Snapshot::load(restore).restore(player.getCpu());
+    }
+
+    auto script = inputs.empty() ? std::vector<Controller::Input>() : Movie::script(inputs);
+
+    Movie movie(path, period);
+    auto frames = player.record(movie, script, std::max<uint64_t>(1, cycles / period), interval);
+
+    if (quiet.enabled) 
+    {
+        summarize({ Summary::read(player.getCpu(), player.getBus(), quiet.from, quiet.to, quiet.memory) }, {}, quiet);
+        return;
+    }
+
+    fmt::print(caption, "\nRecord\n\n");
+    fmt::print("{} frames, {} keyframes written to {}\n", frames, movie.getKeys().size(), path);
+
+    fmt::print(caption, "\n\nMemory dump from {:#04x} to {:#04x}\n", quiet.from, quiet.to);
+    player.getBus().printDump(quiet.from, quiet.to);
+    fmt::print("\n\n");
+}
+
+
+/*
+    Replay movie checking its keyframes and print memory dump
+    Returns false on mismatch
+*/
+bool replay(const std::string & rom, Cpu::Backend backend, const std::string & path, const Quiet & quiet)
+{
+    auto movie = Movie::load(path);
+
+    Player player(rom, backend, movie.getPeriod());
+    uint64_t mismatch = 0;
+
+    auto matches = player.replay(movie, mismatch);
+
+    if (quiet.enabled) 
+    {
+        summarize({ Summary::read(player.getCpu(), player.getBus(), quiet.from, quiet.to, quiet.memory) }, {}, quiet);
+        return matches;
+    }
+
+    fmt::print(caption, "\nReplay\n\n");
+
+    if (!matches) {
+        fmt::print("Keyframe at frame {} does not match\n", mismatch);
+    } else {
+        fmt::print("{} frames, {} keyframes matched\n", player.getFrame(), movie.getKeys().size());
+    }
+
+    fmt::print(caption, "\n\nMemory dump from {:#04x} to {:#04x}\n", quiet.from, quiet.to);
+    player.getBus().printDump(quiet.from, quiet.to);
+    fmt::print("\n\n");
+
+    return matches;
+}
+
+
+/*
+    Replay ranges between keyframes of movie in parallel and print result
+    Returns false if any range does not match
+*/
+bool verify(const std::string & rom, Cpu::Backend backend, const std::string & path, std::size_t threads)
+{
+    auto movie = Movie::load(path);
+
+    auto beg = std::chrono::steady_clock::now();
+    auto segments = Player::verify(rom, backend, movie, threads);
+    auto end = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> elapsed = end - beg;
+
+    fmt::memory_buffer buffer;
+    auto it = std::back_inserter(buffer);
+
+    std::size_t failed = 0;
+
+    for (auto & segment : segments)
+    {
+        if (!segment.error.empty()) {
+            fmt::format_to(it, "frames {:>8} - {:<8} error {}\n", segment.first, segment.last, segment.error);
+        } else if (!segment.matches) {
+            fmt::format_to(it, "frames {:>8} - {:<8} mismatch\n", segment.first, segment.last);
+        }
+
+        failed += !segment.matches;
+    }
+
+    fmt::format_to(it, "{} segments, {} failed, {} threads, {:.3f} s\n", segments.size(), failed, threads, elapsed.count());
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+
+    return failed == 0;
+}
+
+
 /*
     ~
 */
@@ -116,7 +480,60 @@ int main(int argc, char** argv)
     uint16_t f;
     uint16_t t; 
 
-    app.add_option ("-c", c, "CPU loop cycles")                
+    std::string b;
+    std::string rom;
+
+    bool trace = false;
+
+    uint64_t traceFrom;
+    uint64_t traceTo;
+    uint16_t tracePcFrom;
+    uint16_t tracePcTo;
+
+    std::vector<uint16_t> traceOps;
+
+    std::string traceFile;
+
+    std::string snapshot;
+    std::string saveSnapshot;
+
+    std::string batchFile;
+    std::size_t threads;
+
+    bool trap = false;
+
+    bool isCosim = false;
+    uint64_t cosimInterval;
+
+    bool profile = false;
+    std::size_t profileTop;
+    uint32_t profilePeriod;
+    std::string profileStacks;
+
+    std::vector<uint16_t> breakpoints;
+    std::vector<uint16_t> watchWrites;
+    std::vector<uint16_t> watchReads;
+
+    std::string stats;
+
+    bool quiet = false;
+    std::string resultFormat;
+    bool resultMemory = false;
+
+    uint16_t remote = 0;
+
+    std::string recordFile;
+    std::string replayFile;
+    std::string verifyFile;
+    std::string inputScript;
+    uint32_t framePeriod;
+    uint64_t keyframeInterval;
+
+    uint64_t seek;
+    uint64_t rewindInterval;
+    std::size_t rewindDepth;
+
+    app.add_option ("-c", c, "CPU cycles budget")                
         -> default_val(100000000);
 
     app.add_option ("-f", f, "Print memory dump from address") 
@@ -125,17 +542,216 @@ int main(int argc, char** argv)
     app.add_option ("-t", t, "Print memory dump to address")   
         -> default_val(0x00FF);
 
+    app.add_option ("-b", b, "CPU backend (table, fused, cached, jit)")
+        -> default_val("table");
+
+    app.add_option ("--rom", rom, "ROM image, raw 64KB memory or iNES / NES 2.0")
+        -> default_val("../ext/asm/bin_files/6502_functional_test.bin");
+
+    app.add_flag   ("--trace", trace, "Print disassembly of executed instructions");
+
+    app.add_option ("--trace-from", traceFrom, "Trace from instruction number")
+        -> default_val(0);
+
+    app.add_option ("--trace-to", traceTo, "Trace to instruction number")
+        -> default_val(std::numeric_limits<uint64_t>::max());
+
+    app.add_option ("--trace-pc-from", tracePcFrom, "Trace from program counter")
+        -> default_val(0x0000);
+
+    app.add_option ("--trace-pc-to", tracePcTo, "Trace to program counter")
+        -> default_val(0xFFFF);
+
+    app.add_option ("--trace-op", traceOps, "Trace only operation code (repeatable)");
+
+    app.add_option ("--trace-file", traceFile, "Write binary trace to file, implies --trace");
+
+    app.add_option ("--snapshot", snapshot, "Restore machine state from snapshot file before run");
+
+    app.add_option ("--save-snapshot", saveSnapshot, "Save machine state to snapshot file after run");
+
+    app.add_option ("--batch", batchFile, "Run machines listed in file, one \"rom [snapshot]\" per line");
+
+    app.add_option ("-j", threads, "Batch worker threads")
+        -> default_val(std::max(1u, std::thread::hardware_concurrency()));
+
+    app.add_flag   ("--cosim", isCosim, "Run -b backend against table backend, report first diverging instruction");
+
+    app.add_option ("--cosim-interval", cosimInterval, "Co-simulation check interval in cycles")
+        -> default_val(100000)
+        -> check(CLI::PositiveNumber);
+
+    app.add_flag   ("--trap", trap, "Stop at jump or branch to itself and report trap address");
+
+    app.add_flag   ("--profile", profile, "Count instructions and cycles per opcode and PC, print hot list");
+
+    app.add_option ("--profile-top", profileTop, "Hot list length")
+        -> default_val(20);
+
+    app.add_option ("--profile-period", profilePeriod, "Sample host time once per instructions")
+        -> default_val(64)
+        -> check(CLI::PositiveNumber);
+
+    app.add_option ("--profile-stacks", profileStacks, "Write collapsed JSR / RTS stacks for flamegraph, implies --profile");
+
+    app.add_option ("--break", breakpoints, "Stop before instruction at address (repeatable)");
+
+    app.add_option ("--watch", watchWrites, "Stop after write to address (repeatable)");
+
+    app.add_option ("--watch-read", watchReads, "Stop after read from address (repeatable)");
+
+    app.add_option ("--stats", stats, "Print counters after run, batch prints their sum (json, prometheus)");
+
+    app.add_flag   ("--quiet", quiet, "Write only result record of run, batch writes one per machine");
+
+    app.add_option ("--result", resultFormat, "Result record format of --quiet (json, binary)")
+        -> default_val("json");
+
+    app.add_flag   ("--result-memory", resultMemory, "Add -f to -t memory bytes to result record, it always has their hash");
+
+    app.add_option ("--record", recordFile, "Record movie of -c cycles run with controllers on $4016, $4017");
+
+    app.add_option ("--inputs", inputScript, "Input script of --record, one \"frame port1 [port2]\" line per change");
+
+    app.add_option ("--frame-cycles", framePeriod, "CPU cycles per movie frame")
+        -> default_val(29781)
+        -> check(CLI::PositiveNumber);
+
+    app.add_option ("--keyframe-interval", keyframeInterval, "Movie frames between keyframes")
+        -> default_val(600)
+        -> check(CLI::PositiveNumber);
+
+    app.add_option ("--replay", replayFile, "Replay movie from its starting keyframe, check every keyframe");
+
+    app.add_option ("--verify", verifyFile, "Replay ranges between movie keyframes on -j threads");
+
+#ifndef WIN32
+    app.add_option ("--remote", remote, "Wait for debugger on local TCP port, run is paused until it resumes")
+        -> default_val(0);
+#endif
+
+    app.add_option ("--seek", seek, "Go back to state before instruction number after run, memory dump shows it")
+        -> default_val(std::numeric_limits<uint64_t>::max());
+
+    app.add_option ("--rewind-interval", rewindInterval, "Rewind checkpoint interval in cycles")
+        -> default_val(100000)
+        -> check(CLI::PositiveNumber);
+
+    app.add_option ("--rewind-depth", rewindDepth, "Rewind checkpoints kept, older states are out of reach")
+        -> default_val(64)
+        -> check(CLI::PositiveNumber);
+
     try
     {
         app.parse(argc, argv);
+
+        auto backend = Cpu::Backend::Table;
+
+        if (b == "fused") {
+            backend = Cpu::Backend::Fused;
+        } else if (b == "cached") {
+            backend = Cpu::Backend::Cached;
+        } else if (b == "jit") {
+            backend = Cpu::Backend::Jit;
+        } else if (b != "table") {
+            throw CLI::ValidationError("-b", "Unknown backend " + b);
+        }
+
+        if (!stats.empty() && stats != "json" && stats != "prometheus") {
+            throw CLI::ValidationError("--stats", "Unknown format " + stats);
+        }
+
+        if (resultFormat != "json" && resultFormat != "binary") {
+            throw CLI::ValidationError("--result", "Unknown format " + resultFormat);
+        }
+
+        Quiet output;
+
+        output.enabled = quiet;
+        output.binary  = resultFormat == "binary";
+        output.from    = f;
+        output.to      = t;
+        output.memory  = resultMemory;
+
+        // Result record is the only output
+        if (quiet && trace && traceFile.empty()) {
+            throw CLI::ValidationError("--quiet", "Text trace can't be mixed with result, use --trace-file");
+        }
+
+        if (quiet && isCosim) {
+            throw CLI::ValidationError("--quiet", "Co-simulation has no result record");
+        }
+
+        if (quiet && !stats.empty() && (stats != "json" || output.binary)) {
+            throw CLI::ValidationError("--quiet", "Only json counters are added to json result");
+        }
+        
+        std::unique_ptr<Trace> filter;
+
+        if (trace || !traceFile.empty())
+        {
+            filter = std::make_unique<Trace>();
+            filter -> setWindow(traceFrom, traceTo);
+            filter -> setRange(tracePcFrom, tracePcTo);
+
+            for (auto op : traceOps) {
+                filter -> addOpcode((uint8_t) op);
+            }
+        }
         
-        load_rom("6502_functional_test.bin");
+        if (!batchFile.empty()) 
+        {
+            batch (batchFile, c, backend, threads, stats, output);
+            return 0;
+        }
+
+        if (isCosim) {
+            return cosim(rom, c, backend, cosimInterval, snapshot) ? 0 : 1;
+        }
+
+        if (!recordFile.empty()) 
+        {
+            record (rom, c, backend, recordFile, inputScript, framePeriod, keyframeInterval, snapshot, output);
+            return 0;
+        }
+
+        if (!replayFile.empty()) {
+            return replay(rom, backend, replayFile, output) ? 0 : 1;
+        }
+
+        if (!verifyFile.empty()) {
+            return verify(rom, backend, verifyFile, threads) ? 0 : 1;
+        }
+
+        std::unique_ptr<Profile> profiler;
+
+        if (profile || !profileStacks.empty()) {
+            profiler = std::make_unique<Profile>(profilePeriod);
+        }
+
+        auto bus = std::make_shared<Bus>();
+        auto image = load(bus, rom);
+
+        for (auto address : breakpoints) {
+            bus -> watch(address, bus -> getWatch(address) | Bus::Access::Execute);
+        }
+
+        for (auto address : watchWrites) {
+            bus -> watch(address, bus -> getWatch(address) | Bus::Access::Write);
+        }
+
+        for (auto address : watchReads) {
+            bus -> watch(address, bus -> getWatch(address) | Bus::Access::Read);
+        }
 
         // Run CPU loop
-        run (c);
+        run (bus, *image, c, backend, std::move(filter), traceFile, snapshot, saveSnapshot, 
+             std::move(profiler), profileTop, profileStacks, trap, seek, rewindInterval, rewindDepth, stats, remote, output);
  
         // Print memory dump
-        dump (f, t);
+        if (!quiet) {
+            dump (bus, f, t);
+        }
     }
     catch(const CLI::ParseError & e) {
         return app.exit(e);
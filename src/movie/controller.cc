@@ -0,0 +1,106 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "controller.h"
+
+//
+// High byte of address, left on data bus by last read
+//
+
+static const uint8_t openBus = 0x40;
+
+
+/*
+    Read next button of port, or open bus
+*/
+uint8_t Controller::read (uint16_t address)
+{
+    if (address != 0x4016 && address != 0x4017)
+        return openBus;
+
+    auto & shift = state.shift[address & 1];
+
+    // Strobe keeps returning A
+    if (state.strobe) {
+        shift = state.buttons[address & 1];
+    }
+
+    auto data = (uint8_t) (shift & 1);
+    shift = (uint8_t) (shift >> 1 | 0x80);
+
+    return openBus | data;
+}
+
+
+/*
+    Returns button next read would, shift register is kept
+*/
+uint8_t Controller::peek (uint16_t address) const
+{
+    if (address != 0x4016 && address != 0x4017)
+        return openBus;
+
+    // Strobe keeps returning A
+    auto shift = state.strobe 
+        ? state.buttons[address & 1] 
+        : state.shift[address & 1];
+
+    return openBus | (shift & 1);
+}
+
+
+/*
+    Set strobe on $4016, $4017 is APU frame counter
+*/
+void Controller::write (uint16_t address, uint8_t data)
+{
+    if (address != 0x4016)
+        return;
+
+    state.strobe = data & 1;
+
+    if (state.strobe) {
+        state.shift = state.buttons;
+    }
+}
+
+
+/*
+    Hold buttons of both ports
+*/
+void Controller::press (const Input & input)
+{
+    state.buttons = input;
+}
+
+
+/*
+    Returns device state
+*/
+const Controller::State & Controller::getState () const
+{
+    return state;
+}
+
+
+/*
+    Sets device state
+*/
+void Controller::setState (const State & state)
+{
+    this -> state = state;
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <array>
+#include <cstdint>
+
+#include "bus/device.h"
+
+//
+// Standard NES controllers on $4016 and $4017
+//
+// Writing 1 to bit 0 of $4016 holds strobe and reloads both shift
+// registers from held buttons. Each read returns next button in
+// bit 0, A first, and ones once all eight are read. Other addresses
+// of page are open bus, APU is not emulated
+//
+
+class Controller : public Device
+{
+public:
+
+    enum Button : uint8_t
+    {
+        A      = 1 << 0,
+        B      = 1 << 1,
+        Select = 1 << 2,
+        Start  = 1 << 3,
+        Up     = 1 << 4,
+        Down   = 1 << 5,
+        Left   = 1 << 6,
+        Right  = 1 << 7
+    };
+
+    //
+    // Held buttons of both ports
+    //
+
+    using Input = std::array<uint8_t, 2>;
+
+    //
+    // Device state, not part of bus snapshot
+    //
+
+    struct State
+    {
+        Input buttons {};
+        Input shift   {};
+
+        uint8_t strobe = 0;
+    };
+
+private:
+
+    State state;
+
+public:
+
+    /*
+        Read next button of port, or open bus
+    */
+    uint8_t read (uint16_t address) override;
+
+    /*
+        Returns button next read would, shift register is kept
+    */
+    uint8_t peek (uint16_t address) const override;
+
+    /*
+        Set strobe on $4016
+    */
+    void write (uint16_t address, uint8_t data) override;
+
+    /*
+        Hold buttons of both ports
+    */
+    void press (const Input & input);
+
+    /*
+        Returns and sets device state
+    */
+    const State & getState () const;
+    void setState (const State & state);
+};
+
+#endif
@@ -0,0 +1,255 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "movie.h"
+
+/*
+    Start recording file
+*/
+Movie::Movie(const std::string & path, uint32_t period)
+    : file(std::fopen(path.c_str(), "wb"))
+{
+    if (!file) {
+        throw std::runtime_error("Can't open movie file " + path);
+    }
+
+    if (period == 0) {
+        throw std::invalid_argument("Movie frame period must be positive");
+    }
+
+    header.period = period;
+
+    if (std::fwrite(&header, sizeof(Header), 1, file.get()) != 1) {
+        throw std::runtime_error("Can't write movie file " + path);
+    }
+}
+
+
+/*
+    Append inputs not written yet as one chunk
+*/
+bool Movie::flush()
+{
+    if (written == inputs.size())
+        return true;
+
+    uint8_t  tag   = Chunk::Inputs;
+    uint32_t count = (uint32_t) (inputs.size() - written);
+
+    auto ok = std::fwrite(&tag, sizeof(tag), 1, file.get()) == 1
+           && std::fwrite(&count, sizeof(count), 1, file.get()) == 1
+           && std::fwrite(inputs.data() + written, sizeof(Controller::Input), count, file.get()) == count;
+
+    written = inputs.size();
+    return ok;
+}
+
+
+/*
+    Append input of next frame
+*/
+void Movie::add(const Controller::Input & input)
+{
+    inputs.push_back(input);
+}
+
+
+/*
+    Append keyframe after inputs so far
+*/
+void Movie::add(Key key)
+{
+    if (key.frame != inputs.size()) {
+        throw std::invalid_argument("Keyframe must follow inputs of all frames before it");
+    }
+
+    if (file)
+    {
+        uint8_t tag = Chunk::Keyframe;
+
+        auto ok = flush()
+               && std::fwrite(&tag, sizeof(tag), 1, file.get()) == 1
+               && std::fwrite(&key.frame, sizeof(key.frame), 1, file.get()) == 1
+               && std::fwrite(&key.controller, sizeof(key.controller), 1, file.get()) == 1
+               && key.snapshot.save(file.get())
+               && std::fflush(file.get()) == 0;
+
+        if (!ok) {
+            throw std::runtime_error("Can't write movie file");
+        }
+    }
+
+    keys.push_back(std::move(key));
+}
+
+
+/*
+    Read movie file
+*/
+Movie Movie::load(const std::string & path)
+{
+    std::unique_ptr<std::FILE, Closer> file(std::fopen(path.c_str(), "rb"));
+
+    if (!file) {
+        throw std::runtime_error("Can't open movie file " + path);
+    }
+
+    Header expected;
+    Movie movie;
+
+    auto ok = std::fread(&movie.header, sizeof(Header), 1, file.get()) == 1
+           && std::memcmp(movie.header.magic, expected.magic, sizeof(expected.magic)) == 0
+           && movie.header.version == expected.version
+           && movie.header.period != 0;
+
+    if (!ok) {
+        throw std::runtime_error("Invalid movie file " + path);
+    }
+
+    // Partial chunk at the end is left out
+    for (int tag; (tag = std::fgetc(file.get())) != EOF; )
+    {
+        if (tag == Chunk::Inputs)
+        {
+            uint32_t count;
+
+            if (std::fread(&count, sizeof(count), 1, file.get()) != 1)
+                break;
+
+            std::vector<Controller::Input> chunk(count);
+
+            if (std::fread(chunk.data(), sizeof(Controller::Input), count, file.get()) != count)
+                break;
+
+            movie.inputs.insert(movie.inputs.end(), chunk.begin(), chunk.end());
+        }
+        else if (tag == Chunk::Keyframe)
+        {
+            Key key;
+
+            ok = std::fread(&key.frame, sizeof(key.frame), 1, file.get()) == 1
+              && std::fread(&key.controller, sizeof(key.controller), 1, file.get()) == 1
+              && Snapshot::load(file.get(), key.snapshot);
+
+            if (!ok)
+                break;
+
+            if (key.frame != movie.inputs.size()) {
+                throw std::runtime_error("Invalid movie file " + path + ", keyframe out of order");
+            }
+
+            movie.keys.push_back(std::move(key));
+        }
+        else {
+            throw std::runtime_error("Invalid movie file " + path + ", unknown chunk");
+        }
+    }
+
+    if (movie.keys.empty() || movie.keys.front().frame != 0) {
+        throw std::runtime_error("Invalid movie file " + path + ", starting keyframe is missing");
+    }
+
+    movie.written = movie.inputs.size();
+    return movie;
+}
+
+
+/*
+    Read input script
+*/
+std::vector<Controller::Input> Movie::script(const std::string & path)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("File not found " + path);
+    }
+
+    std::vector<Controller::Input> inputs;
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+
+        uint64_t frame;
+        unsigned first;
+        unsigned second = 0;
+
+        stream >> std::ws;
+
+        if (stream.eof() || stream.peek() == '#')
+            continue;
+
+        auto ok = static_cast<bool>(stream >> frame >> std::hex >> first);
+
+        // Second port is optional
+        if (ok) 
+        {
+            stream >> second;
+            ok = !stream.fail() || stream.eof();
+        }
+
+        if (!ok || first > 0xFF || second > 0xFF) {
+            throw std::runtime_error("Invalid input script line \"" + line + "\"");
+        }
+
+        if (frame < inputs.size()) {
+            throw std::runtime_error("Input script frames must increase, line \"" + line + "\"");
+        }
+
+        // Buttons are held until this change
+        auto held = inputs.empty() ? Controller::Input {} : inputs.back();
+        inputs.resize(frame, held);
+
+        inputs.push_back({ (uint8_t) first, (uint8_t) second });
+    }
+
+    return inputs;
+}
+
+
+/*
+    Returns CPU cycles per frame
+*/
+uint32_t Movie::getPeriod() const
+{
+    return header.period;
+}
+
+
+/*
+    Returns inputs of every frame
+*/
+const std::vector<Controller::Input> & Movie::getInputs() const
+{
+    return inputs;
+}
+
+
+/*
+    Returns keyframes in frame order
+*/
+const std::vector<Movie::Key> & Movie::getKeys() const
+{
+    return keys;
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "snapshot/snapshot.h"
+
+//
+// Input movie
+//
+// Controller input of every frame and keyframes of machine state.
+// File is append-only: header, then chunks of frame inputs and
+// keyframes as they are recorded, first keyframe is the starting
+// state. Keyframe holds state after all inputs before it, so range
+// between two keyframes replays and verifies on its own. Movie still
+// being recorded may end in partial chunk, it is left out on load
+//
+
+class Movie
+{
+public:
+
+    //
+    // Movie file header, followed by chunks
+    //
+
+    struct Header
+    {
+        char     magic[8] = { '6', '5', '0', '2', 'M', 'O', 'V', '\0' };
+        uint32_t version  = 1;
+
+        // CPU cycles per frame
+        uint32_t period = 29781;
+    };
+
+    //
+    // Chunk tags
+    // Inputs: count, then both ports of count frames
+    // Keyframe: frame, controller state, snapshot
+    //
+
+    enum Chunk : uint8_t
+    {
+        Inputs   = 'I',
+        Keyframe = 'K'
+    };
+
+    struct Key
+    {
+        // Frames played before state was taken
+        uint64_t frame = 0;
+
+        Controller::State controller;
+        Snapshot snapshot;
+    };
+
+private:
+
+    struct Closer
+    {
+        void operator () (std::FILE * file) const {
+            std::fclose(file);
+        }
+    };
+
+    Header header;
+
+    std::vector<Controller::Input> inputs;
+    std::vector<Key> keys;
+
+    /*
+        File being recorded and number of inputs written to it
+    */
+    std::unique_ptr<std::FILE, Closer> file;
+    std::size_t written = 0;
+
+    /*
+        Append inputs not written yet as one chunk
+    */
+    bool flush();
+
+public:
+
+    Movie() = default;
+
+    /*
+        Start recording file, throws if it can't be written
+    */
+    Movie(const std::string & path, uint32_t period);
+
+    /*
+        Append input of next frame, written with next keyframe
+    */
+    void add(const Controller::Input & input);
+
+    /*
+        Append keyframe after inputs so far, file is flushed
+        Throws on I/O error
+    */
+    void add(Key key);
+
+    /*
+        Read movie file, throws on I/O or format error
+    */
+    static Movie load(const std::string & path);
+
+    /*
+        Read input script, one "frame port1 [port2]" line for every 
+        change of held buttons, buttons are hex. Empty lines and 
+        lines starting with # are skipped. Returns inputs of every 
+        frame up to last change
+    */
+    static std::vector<Controller::Input> script(const std::string & path);
+
+    /*
+        Returns CPU cycles per frame
+    */
+    uint32_t getPeriod() const;
+
+    /*
+        Returns inputs of every frame
+    */
+    const std::vector<Controller::Input> & getInputs() const;
+
+    /*
+        Returns keyframes in frame order
+    */
+    const std::vector<Key> & getKeys() const;
+};
+
+#endif
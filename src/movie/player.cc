@@ -0,0 +1,246 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "player.h"
+
+#include "batch/pool.h"
+
+/*
+    Load ROM image and attach controllers
+*/
+Player::Player(const std::string & rom, Cpu::Backend backend, uint32_t period)
+    : bus(std::make_shared<Bus>()), rom(std::make_unique<Rom>(rom)), 
+      controller(std::make_shared<Controller>()), period(period)
+{
+    if (period == 0) {
+        throw std::invalid_argument("Movie frame period must be positive");
+    }
+
+    this -> rom -> attach(*bus);
+    bus -> attach(0x40, 0x40, controller);
+
+    cpu = std::make_unique<Cpu>(bus, backend);
+    this -> rom -> boot(*cpu);
+}
+
+
+/*
+    Take current state as starting state
+*/
+void Player::start()
+{
+    origin = cpu -> getCycles();
+    frame  = 0;
+}
+
+
+/*
+    Restore keyframe
+*/
+void Player::seek(const Movie::Key & key, uint64_t origin)
+{
+    key.snapshot.restore(*cpu);
+    controller -> setState(key.controller);
+
+    this -> origin = origin;
+    this -> frame  = key.frame;
+}
+
+
+/*
+    Play one frame holding input
+*/
+bool Player::play(const Controller::Input & input)
+{
+    controller -> press(input);
+
+    auto until = origin + (frame + 1) * period;
+
+    if (cpu -> getCycles() < until) {
+        cpu -> run(until - cpu -> getCycles());
+    }
+
+    frame++;
+
+    return !cpu -> isTrapped() && !cpu -> isHalted() && !cpu -> isBreak();
+}
+
+
+/*
+    Returns keyframe of current state
+*/
+Movie::Key Player::capture() const
+{
+    Movie::Key key;
+
+    key.frame      = frame;
+    key.controller = controller -> getState();
+    key.snapshot   = Snapshot(*cpu);
+
+    return key;
+}
+
+
+/*
+    Returns true if current state matches keyframe
+*/
+bool Player::matches(const Movie::Key & key) const
+{
+    auto & l = controller -> getState();
+    auto & r = key.controller;
+
+    return key.frame == frame
+        && l.buttons == r.buttons && l.shift == r.shift && l.strobe == r.strobe
+        && Snapshot(*cpu).matches(key.snapshot);
+}
+
+
+/*
+    Record frames into movie
+*/
+uint64_t Player::record(Movie & movie, const std::vector<Controller::Input> & script, uint64_t frames, uint64_t interval)
+{
+    if (interval == 0) {
+        throw std::invalid_argument("Keyframe interval must be positive");
+    }
+
+    start();
+    movie.add(capture());
+
+    auto running = true;
+
+    while (running && frame < frames)
+    {
+        auto input = frame < script.size() ? script[frame] 
+                   : script.empty()        ? Controller::Input {} : script.back();
+
+        movie.add(input);
+        running = play(input);
+
+        if (!running || frame == frames || frame % interval == 0) {
+            movie.add(capture());
+        }
+    }
+
+    return frame;
+}
+
+
+/*
+    Replay whole movie from starting keyframe
+*/
+bool Player::replay(const Movie & movie, uint64_t & mismatch)
+{
+    auto & keys   = movie.getKeys();
+    auto & inputs = movie.getInputs();
+
+    seek(keys.front(), keys.front().snapshot.getRegisters().cycles);
+
+    for (std::size_t key = 1; key <= keys.size(); key++)
+    {
+        auto last = key < keys.size() ? keys[key].frame : inputs.size();
+
+        while (frame < last) {
+            play(inputs[frame]);
+        }
+
+        if (key < keys.size() && !matches(keys[key])) 
+        {
+            mismatch = keys[key].frame;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+    Replay every range between keyframes on own machine
+*/
+std::vector<Player::Segment> Player::verify(const std::string & rom, Cpu::Backend backend, const Movie & movie, std::size_t threads)
+{
+    auto & keys   = movie.getKeys();
+    auto & inputs = movie.getInputs();
+
+    auto origin = keys.front().snapshot.getRegisters().cycles;
+
+    std::vector<Segment> segments(keys.size() - 1);
+
+    // Each task writes only own segment
+    {
+        Pool pool(threads);
+
+        for (std::size_t index = 0; index < segments.size(); index++)
+        {
+            pool.submit([&, index] 
+            {
+                auto & segment = segments[index];
+
+                segment.first = keys[index].frame;
+                segment.last  = keys[index + 1].frame;
+
+                try
+                {
+                    Player player(rom, backend, movie.getPeriod());
+                    player.seek(keys[index], origin);
+
+                    while (player.frame < segment.last) {
+                        player.play(inputs[player.frame]);
+                    }
+
+                    segment.matches = player.matches(keys[index + 1]);
+                }
+                catch (const std::exception & e) {
+                    segment.error = e.what();
+                }
+            });
+        }
+    }
+
+    return segments;
+}
+
+
+/*
+    Returns CPU
+*/
+Cpu & Player::getCpu()
+{
+    return *cpu;
+}
+
+
+/*
+    Returns bus
+*/
+Bus & Player::getBus()
+{
+    return *bus;
+}
+
+
+/*
+    Returns frames played
+*/
+uint64_t Player::getFrame() const
+{
+    return frame;
+}
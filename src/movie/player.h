@@ -0,0 +1,142 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "movie.h"
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+#include "rom/rom.h"
+
+//
+// Movie player
+//
+// Machine with controllers running frame by frame. Frame N ends at
+// first instruction boundary at or after N + 1 periods from cycle of
+// starting keyframe, its input is held from its start. Recording and
+// replay take the same steps, so replay is bit-exact on any backend
+//
+
+class Player
+{
+public:
+
+    //
+    // Result of replaying range between two keyframes
+    //
+
+    struct Segment
+    {
+        uint64_t first = 0;
+        uint64_t last  = 0;
+
+        bool matches = false;
+
+        // Error message if segment could not run
+        std::string error;
+    };
+
+private:
+
+    std::shared_ptr<Bus> bus;
+    std::unique_ptr<Rom> rom;
+    std::unique_ptr<Cpu> cpu;
+
+    std::shared_ptr<Controller> controller;
+
+    uint32_t period;
+
+    /*
+        Cycle of starting keyframe, and frames played
+    */
+    uint64_t origin = 0;
+    uint64_t frame  = 0;
+
+public:
+
+    /*
+        Load ROM image and attach controllers, throws if ROM can't be loaded
+        Raw images start at $0400, cartridges at RESET vector
+    */
+    Player(const std::string & rom, Cpu::Backend backend, uint32_t period);
+
+    /*
+        Take current state as starting state of frame zero
+    */
+    void start();
+
+    /*
+        Restore keyframe of movie started on cycle origin
+    */
+    void seek(const Movie::Key & key, uint64_t origin);
+
+    /*
+        Play one frame holding input
+        Returns false once CPU stopped on trap, JAM or watchpoint
+    */
+    bool play(const Controller::Input & input);
+
+    /*
+        Returns keyframe of current state
+    */
+    Movie::Key capture() const;
+
+    /*
+        Returns true if current state matches keyframe
+    */
+    bool matches(const Movie::Key & key) const;
+
+    /*
+        Record frames into movie, inputs are taken from script and
+        last one is held after it ends. Keyframe is added every 
+        interval frames and after last frame. Returns frames played
+    */
+    uint64_t record(Movie & movie, const std::vector<Controller::Input> & script, uint64_t frames, uint64_t interval);
+
+    /*
+        Replay whole movie from starting keyframe, checking every keyframe
+        Returns false on first mismatch, frame is set to its keyframe
+    */
+    bool replay(const Movie & movie, uint64_t & mismatch);
+
+    /*
+        Replay every range between keyframes on own machine, 
+        ranges run in parallel on threads
+    */
+    static std::vector<Segment> verify(const std::string & rom, Cpu::Backend backend, const Movie & movie, std::size_t threads);
+
+    /*
+        Returns CPU and its bus
+    */
+    Cpu & getCpu();
+    Bus & getBus();
+
+    /*
+        Returns frames played
+    */
+    uint64_t getFrame() const;
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "profile.h"
+#include "cpu/map.h"
+
+#include "fmt/core.h"
+
+
+/*
+    Allocate counters of every address and root frame
+*/
+Profile::Profile(uint32_t period) : pcs(0x10000), period(period), countdown(period)
+{
+    if (period == 0) {
+        throw std::invalid_argument("Profile sample period must be positive");
+    }
+
+    nodes.push_back({ 0, 0, 0, 0 });
+}
+
+
+/*
+    Returns child frame of current node, creates it on first call
+*/
+uint32_t Profile::enter(uint16_t pc)
+{
+    if (nodes[current].depth == limit)
+        return current;
+
+    uint64_t key = ((uint64_t) current << 16) | pc;
+
+    auto found = children.find(key);
+
+    if (found != children.end())
+        return found -> second;
+
+    auto node = (uint32_t) nodes.size();
+
+    nodes.push_back({ current, pc, (uint16_t) (nodes[current].depth + 1), 0 });
+    children.emplace(key, node);
+
+    return node;
+}
+
+
+/*
+    Returns frame names from root to node joined with ';'
+*/
+std::string Profile::collapse(uint32_t node) const
+{
+    std::vector<uint16_t> frames;
+
+    for (; node != 0; node = nodes[node].parent) {
+        frames.push_back(nodes[node].pc);
+    }
+
+    std::string stack = "main";
+
+    for (auto frame = frames.rbegin(); frame != frames.rend(); frame++) {
+        stack += fmt::format(";${:04X}", *frame);
+    }
+
+    return stack;
+}
+
+
+/*
+    Returns host time stamp, TSC where available
+*/
+uint64_t Profile::ticks()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+#endif
+}
+
+
+/*
+    Print opcodes and addresses sorted by program cycles
+*/
+void Profile::printHot(std::FILE * file, std::size_t top) const
+{
+    uint64_t total = 0;
+
+    for (auto & op : opcodes) {
+        total += op.cycles;
+    }
+
+    if (total == 0)
+        return;
+
+    // Opcodes
+    std::vector<uint16_t> order(opcodes.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::stable_sort(order.begin(), order.end(), [this](uint16_t l, uint16_t r) {
+        return opcodes[l].cycles > opcodes[r].cycles;
+    });
+
+    fmt::print(file, "\n{:<6} {:<4} {:>14} {:>14} {:>7} {:>12}\n", "Opcode", "Name", "Count", "Cycles", "%", "Ticks/instr");
+
+    for (std::size_t i = 0; i < std::min(top, order.size()); i++)
+    {
+        auto opcode = (uint8_t) order[i];
+        auto & op = opcodes[opcode];
+        auto & sample = samples[opcode];
+
+        if (op.count == 0)
+            break;
+
+        fmt::print(file, "${:02X}    {:<4} {:>14} {:>14} {:>6.2f}% {:>12.1f}\n",
+            opcode, Map::getName(opcode), op.count, op.cycles, 100.0 * op.cycles / total,
+            sample.count ? (double) sample.ticks / sample.count : 0.0);
+    }
+
+    // Addresses
+    order.resize(pcs.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    auto last = order.begin() + std::min(top, order.size());
+
+    std::partial_sort(order.begin(), last, order.end(), [this](uint16_t l, uint16_t r) {
+        return pcs[l].cycles > pcs[r].cycles || (pcs[l].cycles == pcs[r].cycles && l < r);
+    });
+
+    fmt::print(file, "\n{:<6} {:>14} {:>14} {:>7}\n", "PC", "Count", "Cycles", "%");
+
+    for (auto pc = order.begin(); pc != last; pc++)
+    {
+        auto & at = pcs[*pc];
+
+        if (at.count == 0)
+            break;
+
+        fmt::print(file, "${:04X} {:>14} {:>14} {:>6.2f}%\n", *pc, at.count, at.cycles, 100.0 * at.cycles / total);
+    }
+}
+
+
+/*
+    Write call tree in collapsed stack format
+*/
+void Profile::saveStacks(const std::string & path) const
+{
+    auto file = std::fopen(path.c_str(), "w");
+
+    if (file == nullptr) {
+        throw std::runtime_error("Can't open stacks file " + path);
+    }
+
+    for (uint32_t node = 0; node < nodes.size(); node++)
+    {
+        if (nodes[node].cycles > 0) {
+            fmt::print(file, "{} {}\n", collapse(node), nodes[node].cycles);
+        }
+    }
+
+    std::fclose(file);
+}
+
+
+/*
+    Returns counters of opcode
+*/
+const Profile::Counter & Profile::getOpcode(uint8_t opcode) const
+{
+    return opcodes[opcode];
+}
+
+
+/*
+    Returns counters of instruction address
+*/
+const Profile::Counter & Profile::getPc(uint16_t pc) const
+{
+    return pcs[pc];
+}
+
+
+/*
+    Returns host time samples of opcode
+*/
+const Profile::Sample & Profile::getSample(uint8_t opcode) const
+{
+    return samples[opcode];
+}
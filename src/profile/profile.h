@@ -0,0 +1,208 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// Execution profiler
+//
+// Counts executions and program cycles per opcode and per PC,
+// samples host time of every n-th instruction per opcode and
+// keeps call tree built from JSR / RTS nesting.
+// Used by the profiled run loop only, plain loop has no checks
+//
+
+class Profile
+{
+public:
+
+    /*
+        Counters of single opcode or address
+    */
+    struct Counter
+    {
+        uint64_t count  = 0;
+        uint64_t cycles = 0;
+    };
+
+    /*
+        Host time samples of single opcode
+    */
+    struct Sample
+    {
+        uint64_t count = 0;
+        uint64_t ticks = 0;
+    };
+
+private:
+
+    /*
+        Call tree node, frames are entry addresses of subroutines
+    */
+    struct Node
+    {
+        uint32_t parent;
+        uint16_t pc;
+        uint16_t depth;
+
+        // Program cycles spent in frame itself
+        uint64_t cycles;
+    };
+
+    std::array<Counter, 256> opcodes {};
+    std::array<Sample,  256> samples {};
+
+    std::vector<Counter> pcs;
+
+    std::vector<Node> nodes;
+
+    /*
+        Stack page holds at most 128 return addresses,
+        deeper JSR without RTS stay in current frame
+    */
+    static const uint16_t limit = 128;
+
+    /*
+        Child node by parent node and entry address
+    */
+    std::unordered_map<uint64_t, uint32_t> children;
+
+    uint32_t current = 0;
+
+    /*
+        Instructions left until next host time sample
+        Interval is jittered around period so that samples
+        do not lock onto loops of period length
+    */
+    uint32_t period;
+    uint32_t countdown;
+
+    // Xorshift state of jitter
+    uint32_t seed = 0x6502;
+
+    /*
+        Returns child frame of current node, creates it on first call
+    */
+    uint32_t enter(uint16_t pc);
+
+    /*
+        Returns frame names from root to node joined with ';'
+    */
+    std::string collapse(uint32_t node) const;
+
+public:
+
+    /*
+        Host time is sampled once per period instructions on average
+    */
+    Profile(uint32_t period = 64);
+
+    /*
+        Returns true when next instruction is timed
+    */
+    bool sampling()
+    {
+        if (--countdown > 0)
+            return false;
+
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+
+        countdown = 1 + period / 2 + seed % period;
+        return true;
+    }
+
+    /*
+        Count instruction at pc which executed for cycles
+        and left program counter at next
+    */
+    void count(uint16_t pc, uint8_t opcode, uint64_t cycles, uint16_t next)
+    {
+        auto & op = opcodes[opcode];
+
+        op.count++;
+        op.cycles += cycles;
+
+        auto & at = pcs[pc];
+
+        at.count++;
+        at.cycles += cycles;
+
+        nodes[current].cycles += cycles;
+
+        // JSR enters frame of its target, RTS returns to caller frame
+        if (opcode == 0x20) {
+            current = enter(next);
+        } else if (opcode == 0x60 && current != 0) {
+            current = nodes[current].parent;
+        }
+    }
+
+    /*
+        Add host time sample of opcode
+    */
+    void time(uint8_t opcode, uint64_t ticks)
+    {
+        auto & sample = samples[opcode];
+
+        sample.count++;
+        sample.ticks += ticks;
+    }
+
+    /*
+        Returns host time stamp, TSC where available
+    */
+    static uint64_t ticks();
+
+    /*
+        Print opcodes and addresses sorted by program cycles,
+        at most top lines of each
+    */
+    void printHot(std::FILE * file, std::size_t top) const;
+
+    /*
+        Write call tree in collapsed stack format, one
+        "frame;frame;frame cycles" line per node
+    */
+    void saveStacks(const std::string & path) const;
+
+    /*
+        Returns counters of opcode
+    */
+    const Counter & getOpcode(uint8_t opcode) const;
+
+    /*
+        Returns counters of instruction address
+    */
+    const Counter & getPc(uint16_t pc) const;
+
+    /*
+        Returns host time samples of opcode
+    */
+    const Sample & getSample(uint8_t opcode) const;
+};
+
+#endif
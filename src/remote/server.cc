@@ -0,0 +1,557 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "snapshot/snapshot.h"
+#include "trace/trace.h"
+
+#include "fmt/core.h"
+
+/*
+    Listen on loopback TCP port, start I/O thread
+*/
+Server::Server(Cpu & cpu, std::shared_ptr<Bus> bus, uint16_t port)
+    : cpu(cpu), bus(std::move(bus)), commands(64), replies(256)
+{
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listener < 0) {
+        throw std::runtime_error("Can't open remote socket");
+    }
+
+    int reuse = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Debugger may write memory, only local clients or tunnels reach it
+    sockaddr_in address {};
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::bind(listener, (sockaddr *) &address, sizeof(address)) < 0 || ::listen(listener, 1) < 0)
+    {
+        ::close(listener);
+        throw std::runtime_error(fmt::format("Can't listen on remote port {}", port));
+    }
+
+    io = std::thread(&Server::serve, this);
+}
+
+
+/*
+    Stop trace and I/O thread, close sockets
+*/
+Server::~Server()
+{
+    cpu.setTrace(nullptr);
+    cpu.setRecorder(nullptr);
+    recorder.reset();
+
+    running.store(false, std::memory_order_release);
+    io.join();
+
+    if (client >= 0) {
+        ::close(client);
+    }
+
+    ::close(listener);
+}
+
+
+/*
+    Send bytes to client, dropped if it is detached
+*/
+void Server::send(const void * data, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(output);
+    write(data, size);
+}
+
+
+/*
+    Send bytes with output lock held
+*/
+void Server::write(const void * data, std::size_t size)
+{
+    auto bytes = static_cast<const char *>(data);
+
+    while (client >= 0 && size > 0)
+    {
+        auto sent = ::send(client, bytes, size, MSG_NOSIGNAL);
+
+        if (sent <= 0)
+            break;
+
+        bytes += sent;
+        size  -= (std::size_t) sent;
+    }
+}
+
+
+/*
+    I/O thread loop
+    Accepts client, splits its input into lines and forwards replies
+*/
+void Server::serve()
+{
+    std::string input;
+
+    while (running.load(std::memory_order_acquire))
+    {
+        Reply answer;
+
+        while (replies.pop(answer)) {
+            send(answer.text.data(), answer.size);
+        }
+
+        pollfd ready { client >= 0 ? client : listener, POLLIN, 0 };
+
+        if (::poll(&ready, 1, 10) <= 0)
+            continue;
+
+        if (client < 0)
+        {
+            auto accepted = ::accept(listener, nullptr, nullptr);
+
+            if (accepted >= 0)
+            {
+                std::lock_guard<std::mutex> lock(output);
+
+                client = accepted;
+                attached.store(true, std::memory_order_release);
+            }
+
+            continue;
+        }
+
+        char chunk[512];
+        auto size = ::recv(client, chunk, sizeof(chunk), 0);
+
+        if (size <= 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(output);
+
+                ::close(client);
+
+                client = -1;
+                attached.store(false, std::memory_order_release);
+            }
+
+            input.clear();
+
+            Command detach {};
+            detach.kind = Command::Detach;
+
+            while (!commands.push(detach) && running.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            continue;
+        }
+
+        input.append(chunk, (std::size_t) size);
+
+        std::size_t end;
+
+        while ((end = input.find('\n')) != std::string::npos)
+        {
+            auto line = input.substr(0, end);
+            input.erase(0, end + 1);
+
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+
+            if (line.empty())
+                continue;
+
+            Command command {};
+            std::string error;
+
+            if (!parse(line, command, error)) {
+                error = "error " + error + "\n";
+            } else if (!commands.push(command)) {
+                error = "error busy\n";
+            }
+
+            if (!error.empty()) {
+                send(error.data(), error.size());
+            }
+        }
+    }
+
+    // Last replies, such as answer to quit
+    Reply answer;
+
+    while (replies.pop(answer)) {
+        send(answer.text.data(), answer.size);
+    }
+}
+
+
+/*
+    Parse client line
+*/
+bool Server::parse(const std::string & line, Command & command, std::string & error)
+{
+    std::istringstream stream(line);
+    std::vector<std::string> words;
+
+    for (std::string word; stream >> word; ) {
+        words.push_back(word);
+    }
+
+    if (words.empty())
+    {
+        error = "empty command";
+        return false;
+    }
+
+    auto & name = words[0];
+    auto count  = words.size();
+
+    // Hex argument at index, fallback if it is missing
+    auto number = [&words](std::size_t index, uint64_t fallback) -> uint64_t {
+        return index < words.size() ? std::stoull(words[index], nullptr, 16) : fallback;
+    };
+
+    try
+    {
+        if (name == "pause") {
+            command.kind = Command::Pause;
+        } else if (name == "resume") {
+            command.kind = Command::Resume;
+        } else if (name == "step") {
+            command.kind  = Command::Step;
+            command.value = number(1, 1);
+        } else if (name == "regs") {
+            command.kind = Command::Regs;
+        } else if (name == "quit") {
+            command.kind = Command::Quit;
+        }
+        else if (name == "set" && count == 3)
+        {
+            static const std::string registers[] = { "pc", "a", "x", "y", "s", "p" };
+
+            auto found = std::find(std::begin(registers), std::end(registers), words[1]);
+
+            if (found == std::end(registers))
+            {
+                error = "unknown register " + words[1];
+                return false;
+            }
+
+            // Program counter is 'c', others by their name
+            command.kind  = Command::Set;
+            command.name  = *found == "pc" ? 'c' : (*found)[0];
+            command.value = number(2, 0);
+        }
+        else if (name == "read" && count >= 2)
+        {
+            command.kind    = Command::Read;
+            command.address = (uint16_t) number(1, 0);
+            command.size    = (uint16_t) std::min<uint64_t>(number(2, 1), command.data.size());
+        }
+        else if (name == "write" && count >= 3 && count - 2 <= command.data.size())
+        {
+            command.kind    = Command::Write;
+            command.address = (uint16_t) number(1, 0);
+            command.size    = (uint16_t) (count - 2);
+
+            for (std::size_t index = 0; index < command.size; index++) {
+                command.data[index] = (uint8_t) number(index + 2, 0);
+            }
+        }
+        else if ((name == "break" || name == "watch" || name == "delete") && count >= 2)
+        {
+            command.kind    = Command::Watch;
+            command.address = (uint16_t) number(1, 0);
+            command.value   = 0;
+
+            if (name == "break") {
+                command.value = Bus::Access::Execute;
+            }
+            else if (name == "watch")
+            {
+                auto access = count > 2 ? words[2] : "w";
+
+                if (access.find('r') != std::string::npos) command.value |= Bus::Access::Read;
+                if (access.find('w') != std::string::npos) command.value |= Bus::Access::Write;
+            }
+
+            // Delete is marked by name, it clears every access kind
+            command.name = name[0];
+        }
+        else if (name == "trace" && count == 2 && (words[1] == "on" || words[1] == "off"))
+        {
+            command.kind  = Command::Trace;
+            command.value = words[1] == "on";
+        }
+        else
+        {
+            error = "unknown command " + line;
+            return false;
+        }
+    }
+    catch (const std::exception &)
+    {
+        error = "bad number in " + line;
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+    Queue reply line for I/O thread, dropped if queue is full
+*/
+void Server::reply(const std::string & text)
+{
+    Reply answer;
+
+    answer.size = (uint16_t) std::min(text.size() + 1, answer.text.size());
+
+    std::copy(text.begin(), text.begin() + (answer.size - 1), answer.text.begin());
+    answer.text[answer.size - 1] = '\n';
+
+    replies.push(answer);
+}
+
+
+/*
+    Returns registers as reply text
+*/
+std::string Server::registers() const
+{
+    auto r = Snapshot::read(cpu);
+
+    return fmt::format("PC:{:04X} A:{:02X} X:{:02X} Y:{:02X} S:{:02X} P:{:02X} instructions {} cycles {}",
+        r.pc, r.a, r.x, r.y, r.s, r.p, r.instructions, r.cycles);
+}
+
+
+/*
+    Apply command on emulation thread
+*/
+void Server::apply(const Command & command)
+{
+    switch (command.kind)
+    {
+        case Command::Pause:
+            paused = true;
+            reply("ok " + registers());
+            break;
+
+        case Command::Resume:
+            paused = false;
+            reply("ok");
+            break;
+
+        case Command::Step:
+        {
+            // Single steps pass trace
+            for (uint64_t step = 0; step < command.value; step++) {
+                cpu.clock();
+            }
+
+            reply("ok " + registers());
+            break;
+        }
+
+        case Command::Regs:
+            reply("ok " + registers());
+            break;
+
+        case Command::Set:
+        {
+            auto r = Snapshot::read(cpu);
+
+            switch (command.name)
+            {
+                case 'c': r.pc = (uint16_t) command.value; break;
+                case 'a': r.a  = (uint8_t)  command.value; break;
+                case 'x': r.x  = (uint8_t)  command.value; break;
+                case 'y': r.y  = (uint8_t)  command.value; break;
+                case 's': r.s  = (uint8_t)  command.value; break;
+                case 'p': r.p  = (uint8_t)  command.value; break;
+            }
+
+            Snapshot::write(cpu, r);
+            reply("ok " + registers());
+            break;
+        }
+
+        case Command::Read:
+        {
+            std::string text = "ok";
+
+            for (uint16_t index = 0; index < command.size; index++) {
+                text += fmt::format(" {:02X}", bus -> peek(command.address + index));
+            }
+
+            reply(text);
+            break;
+        }
+
+        case Command::Write:
+        {
+            // Debugger writes are neither observed nor watched
+            uint16_t stored = 0;
+
+            for (uint16_t index = 0; index < command.size; index++) {
+                stored += bus -> poke(command.address + index, command.data[index]);
+            }
+
+            reply(stored == command.size ? "ok" : fmt::format("error {} bytes are not RAM", command.size - stored));
+            break;
+        }
+
+        case Command::Watch:
+        {
+            auto access = command.name == 'd' ? 0 : bus -> getWatch(command.address) | command.value;
+
+            bus -> watch(command.address, (uint8_t) access);
+            reply(fmt::format("ok {:04X}", command.address));
+            break;
+        }
+
+        case Command::Detach:
+            // Detached program keeps running
+            paused = false;
+
+            [[fallthrough]];
+
+        case Command::Trace:
+        {
+            auto on = command.kind == Command::Trace && command.value;
+
+            if (on && !recorder)
+            {
+                recorder = std::make_unique<Recorder>([this](const Record * records, std::size_t count) {
+                    auto header = fmt::format("R {}\n", count);
+
+                    // Header and records are not split by other replies
+                    std::lock_guard<std::mutex> lock(output);
+
+                    write(header.data(), header.size());
+                    write(records, count * sizeof(Record));
+                }, 1 << 16);
+
+                cpu.setRecorder(recorder.get());
+                cpu.setTrace(std::make_unique<Trace>());
+            }
+            else if (!on && recorder)
+            {
+                cpu.setTrace(nullptr);
+                cpu.setRecorder(nullptr);
+                recorder.reset();
+            }
+
+            if (command.kind == Command::Trace) {
+                reply("ok");
+            }
+
+            break;
+        }
+
+        case Command::Quit:
+            quit = true;
+            reply("ok");
+            break;
+    }
+}
+
+
+/*
+    Report stop after slice, stopped CPU stays paused
+*/
+void Server::report(uint64_t until)
+{
+    if (cpu.isBreak())
+    {
+        auto & hit = bus -> getHit();
+
+        auto access = hit.access == Bus::Access::Execute ? "x"
+                    : hit.access == Bus::Access::Write   ? "w" : "r";
+
+        reply(fmt::format("break {} {:04X} {:02X} {}", access, hit.address, hit.data, registers()));
+    }
+    else if (cpu.isTrapped()) {
+        reply("trap " + registers());
+    }
+    else if (cpu.isHalted()) {
+        reply("halt " + registers());
+    }
+    else if (cpu.getCycles() >= until) {
+        reply("done " + registers());
+    }
+    else {
+        return;
+    }
+
+    paused = true;
+}
+
+
+/*
+    Run CPU in slices, apply client commands between them
+*/
+uint64_t Server::run(uint64_t budget, uint64_t slice)
+{
+    auto start = cpu.getCycles();
+    auto until = start + budget;
+
+    while (!quit)
+    {
+        Command command;
+
+        while (commands.pop(command)) {
+            apply(command);
+        }
+
+        auto done = cpu.getCycles() >= until;
+
+        // Finished program waits for client to look at it
+        if (done && !attached.load(std::memory_order_acquire))
+            break;
+
+        if (paused || done)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        cpu.run(std::min(slice, until - cpu.getCycles()));
+        report(until);
+    }
+
+    return cpu.getCycles() - start;
+}
@@ -0,0 +1,186 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+#include "trace/recorder.h"
+#include "trace/ring.h"
+
+//
+// Remote debug server
+//
+// Line based text protocol on TCP socket, one client at a time.
+// I/O thread parses commands into lock-free queue, emulation
+// thread applies them between run() slices and queues replies
+// back, so the core never waits on the socket.
+//
+//   pause | resume | step [n] | regs | set <reg> <hex>
+//   read <addr> [n] | write <addr> <hex bytes...>
+//   break <addr> | watch <addr> [r|w|rw] | delete <addr>
+//   trace on | trace off | quit
+//
+// Numbers are hex. Replies are lines starting with "ok" or
+// "error", stops are reported as "break", "trap", "halt" or "done" lines.
+// Traced instructions are sent as "R <n>" line followed by n
+// binary records of trace file format
+//
+
+class Server
+{
+private:
+
+    struct Command
+    {
+        enum Kind : uint8_t
+        {
+            Pause, Resume, Step, Regs, Set, Read, Write, Watch, Trace, Quit, Detach
+        };
+
+        Kind kind;
+
+        // Register name, or first letter of break / watch / delete
+        char name;
+
+        uint16_t address;
+        uint64_t value;
+
+        // Bytes of write
+        uint16_t size;
+        std::array<uint8_t, 256> data;
+    };
+
+    struct Reply
+    {
+        uint16_t size;
+        std::array<char, 1024> text;
+    };
+
+    Cpu & cpu;
+    std::shared_ptr<Bus> bus;
+
+    /*
+        Client to emulation and back
+    */
+    Ring<Command> commands;
+    Ring<Reply> replies;
+
+    /*
+        Listening and client sockets, client is -1 when detached
+    */
+    int listener = -1;
+    int client   = -1;
+
+    /*
+        Socket writes of I/O and trace threads
+    */
+    std::mutex output;
+
+    std::thread io;
+    std::atomic<bool> running { true };
+
+    /*
+        Client is connected, read by emulation thread
+    */
+    std::atomic<bool> attached { false };
+
+    /*
+        Emulation thread state
+    */
+    bool paused = true;
+    bool quit   = false;
+
+    /*
+        Streams traced instructions while trace is on
+    */
+    std::unique_ptr<Recorder> recorder;
+
+    /*
+        I/O thread loop
+    */
+    void serve();
+
+    /*
+        Parse client line, returns false with error text
+    */
+    static bool parse(const std::string & line, Command & command, std::string & error);
+
+    /*
+        Send bytes to client, dropped if it is detached
+    */
+    void send(const void * data, std::size_t size);
+
+    /*
+        Send bytes with output lock held
+    */
+    void write(const void * data, std::size_t size);
+
+    /*
+        Apply command on emulation thread
+    */
+    void apply(const Command & command);
+
+    /*
+        Queue reply line for I/O thread
+    */
+    void reply(const std::string & text);
+
+    /*
+        Returns registers as reply text
+    */
+    std::string registers() const;
+
+    /*
+        Report stop after slice
+    */
+    void report(uint64_t until);
+
+public:
+
+    /*
+        Listen on TCP port and start I/O thread
+        Throws if socket can't be opened
+    */
+    Server(Cpu & cpu, std::shared_ptr<Bus> bus, uint16_t port);
+
+    /*
+        Stop trace and I/O thread, close sockets
+    */
+    ~Server();
+
+    Server(const Server &) = delete;
+    Server & operator = (const Server &) = delete;
+
+    /*
+        Run CPU for cycle budget in slices, applying client commands
+        between them. Starts paused, waits for client after budget
+        is done until it quits or detaches. Returns executed cycles
+    */
+    uint64_t run(uint64_t budget, uint64_t slice = 10000);
+};
+
+#endif
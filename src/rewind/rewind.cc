@@ -0,0 +1,205 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "rewind.h"
+#include "cpu/mem.h"
+
+/*
+    Journal writes on host memory, take first checkpoint
+*/
+Rewind::Rewind(Cpu & cpu, uint64_t interval, std::size_t depth)
+    : cpu(cpu), bus(cpu.mem.getBus()), interval(interval), depth(depth)
+{
+    if (interval == 0 || depth == 0) {
+        throw std::invalid_argument("Rewind interval and depth must be positive");
+    }
+
+    // Device reads may have side effects, their writes are not undone
+    bus.observe([this](uint16_t address, uint8_t) {
+        if (!this -> bus.isDevice(address)) {
+            journal.push_back({ address, this -> bus.peek(address) });
+        }
+    });
+
+    checkpoint();
+}
+
+
+/*
+    Stop observing bus
+*/
+Rewind::~Rewind()
+{
+    bus.observe(nullptr);
+}
+
+
+/*
+    Record checkpoint, drop oldest one over depth
+*/
+void Rewind::checkpoint()
+{
+    checkpoints.push_back({ Snapshot::read(cpu), base + journal.size() });
+
+    if (checkpoints.size() <= depth)
+        return;
+
+    checkpoints.pop_front();
+
+    // Journal before oldest checkpoint can't be reached anymore
+    auto & oldest = checkpoints.front();
+
+    journal.erase(journal.begin(), journal.begin() + (std::ptrdiff_t) (oldest.journal - base));
+    base = oldest.journal;
+}
+
+
+/*
+    Undo journal down to length, newest write first
+    Undone writes are neither observed nor watched
+*/
+void Rewind::undo(uint64_t length)
+{
+    while (base + journal.size() > length)
+    {
+        auto entry = journal.back();
+        journal.pop_back();
+
+        bus.poke(entry.address, entry.value);
+    }
+}
+
+
+/*
+    Returns cycle of next checkpoint
+*/
+uint64_t Rewind::next() const
+{
+    return checkpoints.back().registers.cycles + interval;
+}
+
+
+/*
+    Run CPU for cycle budget taking checkpoints
+*/
+uint64_t Rewind::run(uint64_t budget)
+{
+    auto start = cpu.cycles;
+    auto until = start + budget;
+
+    while (cpu.cycles < until)
+    {
+        auto cycles = std::min(next(), until) - cpu.cycles;
+        auto executed = cpu.run(cycles);
+
+        if (cpu.cycles >= next()) {
+            checkpoint();
+        }
+
+        // Stopped or trapped
+        if (executed < cycles)
+            break;
+    }
+
+    return cpu.cycles - start;
+}
+
+
+/*
+    Go back or forward to state before instruction number
+*/
+bool Rewind::seek(uint64_t instruction)
+{
+    if (instruction < getOldest())
+        return false;
+
+    if (instruction < cpu.counter)
+    {
+        // Oldest checkpoint is never newer than instruction
+        while (checkpoints.back().registers.instructions > instruction) {
+            checkpoints.pop_back();
+        }
+
+        auto & nearest = checkpoints.back();
+
+        undo(nearest.journal);
+        Snapshot::write(cpu, nearest.registers);
+
+        // Trap and JAM are found again on replay if they are still ahead
+        cpu.events &= ~(Cpu::Event::Trap | Cpu::Event::Halt);
+    }
+
+    while (cpu.counter < instruction)
+    {
+        auto boundary = next();
+
+        cpu.runUntil([instruction, boundary](const Cpu & state) {
+            return state.counter >= instruction || state.cycles >= boundary;
+        });
+
+        // Replay does not stop on breakpoints and watchpoints
+        auto hit = cpu.events & Cpu::Event::Break;
+        cpu.events &= ~Cpu::Event::Break;
+
+        if (cpu.cycles >= boundary) {
+            checkpoint();
+        } else if (cpu.counter < instruction && !hit) {
+            break;
+        }
+    }
+
+    return cpu.counter == instruction;
+}
+
+
+/*
+    Go back one instruction
+*/
+bool Rewind::stepBack()
+{
+    return cpu.counter > 0 && seek(cpu.counter - 1);
+}
+
+
+/*
+    Returns instruction number of oldest reachable state
+*/
+uint64_t Rewind::getOldest() const
+{
+    return checkpoints.front().registers.instructions;
+}
+
+
+/*
+    Returns number of kept checkpoints
+*/
+std::size_t Rewind::getCheckpoints() const
+{
+    return checkpoints.size();
+}
+
+
+/*
+    Returns number of kept journal entries
+*/
+std::size_t Rewind::getJournal() const
+{
+    return journal.size();
+}
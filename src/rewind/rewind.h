@@ -0,0 +1,135 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <cstdint>
+#include <deque>
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+#include "snapshot/snapshot.h"
+
+//
+// Reverse execution
+//
+// Records registers every interval cycles and a journal of
+// previous values of every written byte. Going back undoes
+// journal down to nearest checkpoint, then replays forward
+// to requested instruction. Only last depth checkpoints are
+// kept, older journal is dropped with them.
+//
+// Rewind takes over bus write observer. Device state and
+// scheduled events are not recorded, replay over them is
+// exact only if devices answer the same way again
+//
+
+class Rewind
+{
+private:
+
+    struct Checkpoint
+    {
+        Snapshot::Registers registers;
+
+        // Journal length when checkpoint was taken
+        uint64_t journal;
+    };
+
+    struct Entry
+    {
+        uint16_t address;
+
+        // Value before write
+        uint8_t value;
+    };
+
+    Cpu & cpu;
+    Bus & bus;
+
+    uint64_t interval;
+    std::size_t depth;
+
+    std::deque<Checkpoint> checkpoints;
+
+    /*
+        Writes since oldest checkpoint, base is number of
+        entries dropped from front
+    */
+    std::deque<Entry> journal;
+    uint64_t base = 0;
+
+    /*
+        Record checkpoint, drop oldest one over depth
+    */
+    void checkpoint();
+
+    /*
+        Undo journal down to length
+    */
+    void undo(uint64_t length);
+
+    /*
+        Returns cycle of next checkpoint
+    */
+    uint64_t next() const;
+
+public:
+
+    /*
+        Record CPU and its bus from current state,
+        checkpoint every interval cycles, keep depth checkpoints
+    */
+    Rewind(Cpu & cpu, uint64_t interval = 100000, std::size_t depth = 64);
+
+    ~Rewind();
+
+    Rewind(const Rewind &) = delete;
+    Rewind & operator = (const Rewind &) = delete;
+
+    /*
+        Run CPU for cycle budget taking checkpoints
+        Returns executed cycles
+    */
+    uint64_t run(uint64_t budget);
+
+    /*
+        Go back or forward to state before instruction number,
+        watchpoints are not hit on the way. Returns false if it 
+        is older than first checkpoint or run stopped before it
+    */
+    bool seek(uint64_t instruction);
+
+    /*
+        Go back one instruction
+    */
+    bool stepBack();
+
+    /*
+        Returns instruction number of oldest reachable state
+    */
+    uint64_t getOldest() const;
+
+    /*
+        Returns number of kept checkpoints and journal entries
+    */
+    std::size_t getCheckpoints() const;
+    std::size_t getJournal() const;
+};
+
+#endif
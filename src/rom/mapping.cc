@@ -0,0 +1,128 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "mapping.h"
+
+#ifdef WIN32
+
+/*
+    Map file copy-on-write
+*/
+Mapping::Mapping(const std::string & path)
+{
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::runtime_error("File not found " + path);
+    }
+
+    LARGE_INTEGER length;
+    GetFileSizeEx(file, &length);
+
+    size = static_cast<std::size_t>(length.QuadPart);
+
+    // Empty file can't be mapped
+    if (size == 0)
+        return;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+
+    if (mapping != nullptr) {
+        data = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    }
+
+    if (data == nullptr) 
+    {
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+
+        CloseHandle(file);
+        throw std::runtime_error("Can't map file " + path);
+    }
+}
+
+
+/*
+    Unmap view and close handles
+*/
+Mapping::~Mapping()
+{
+    if (data != nullptr) 
+        UnmapViewOfFile(data);
+
+    if (mapping != nullptr) 
+        CloseHandle(mapping);
+
+    if (file != nullptr) 
+        CloseHandle(file);
+}
+
+#else
+
+/*
+    Map file copy-on-write
+*/
+Mapping::Mapping(const std::string & path)
+{
+    auto file = open(path.c_str(), O_RDONLY);
+
+    if (file < 0) {
+        throw std::runtime_error("File not found " + path);
+    }
+
+    struct stat info;
+
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        size = static_cast<std::size_t>(info.st_size);
+
+        auto view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        data = view == MAP_FAILED ? nullptr : static_cast<uint8_t *>(view);
+    }
+
+    // Mapping stays valid after descriptor is closed
+    close(file);
+
+    if (size > 0 && data == nullptr) {
+        throw std::runtime_error("Can't map file " + path);
+    }
+}
+
+
+/*
+    Unmap file
+*/
+Mapping::~Mapping()
+{
+    if (data != nullptr) {
+        munmap(data, size);
+    }
+}
+
+#endif
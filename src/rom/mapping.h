@@ -0,0 +1,78 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPPING_H
+#define MAPPING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//
+// Memory mapped file
+//
+// File is mapped private copy-on-write: pages are read from disk
+// on first access and writes stay in process memory, so image
+// can be mapped to bus as writable RAM without copying it
+//
+
+class Mapping
+{
+private:
+
+    uint8_t * data = nullptr;
+    std::size_t size = 0;
+
+    #ifdef WIN32
+
+        // File and mapping object handles
+        void * file = nullptr;
+        void * mapping = nullptr;
+
+    #endif
+
+public:
+
+    /*
+        Map file, throws if file can't be opened or mapped
+    */
+    Mapping(const std::string & path);
+
+    /*
+        Unmap file
+    */
+    ~Mapping();
+
+    Mapping(const Mapping &) = delete;
+    Mapping & operator = (const Mapping &) = delete;
+
+    /*
+        Returns mapped file content
+    */
+    uint8_t * begin() const {
+        return data;
+    }
+
+    /*
+        Returns file size in bytes
+    */
+    std::size_t getSize() const {
+        return size;
+    }
+};
+
+#endif
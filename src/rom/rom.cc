@@ -0,0 +1,178 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "rom.h"
+#include "bus/bus.h"
+#include "cpu/cpu.h"
+
+/*
+    iNES header layout
+*/
+static const std::size_t header  = 16;
+static const std::size_t trainer = 512;
+
+static const std::size_t prgBank = 16 * 1024;
+static const std::size_t chrBank = 8 * 1024;
+
+/*
+    Returns NES 2.0 bank area size from LSB byte and MSB nibble
+    MSB nibble $F means exponent-multiplier notation
+*/
+static std::size_t banks(uint8_t lsb, uint8_t msb, std::size_t bank)
+{
+    if (msb != 0x0F) {
+        return ((msb << 8) | lsb) * bank;
+    }
+
+    std::size_t exponent   = lsb >> 2;
+    std::size_t multiplier = (lsb & 0x03) * 2 + 1;
+
+    return (std::size_t(1) << exponent) * multiplier;
+}
+
+
+/*
+    Map image file
+*/
+Rom::Rom(const std::string & path) : image(path)
+{
+    parse();
+}
+
+
+/*
+    Parse cartridge header if image has one
+*/
+void Rom::parse()
+{
+    auto data = image.begin();
+    auto size = image.getSize();
+
+    if (size < header || std::memcmp(data, "NES\x1A", 4) != 0)
+        return;
+
+    // Bits 2-3 of flags 7 are 10 for NES 2.0
+    format = (data[7] & 0x0C) == 0x08 ? Format::Nes2 : Format::INes;
+    mapper = (data[6] >> 4) | (data[7] & 0xF0);
+
+    if (format == Format::Nes2)
+    {
+        mapper |= (data[8] & 0x0F) << 8;
+
+        prgSize = banks(data[4], data[9] & 0x0F, prgBank);
+        chrSize = banks(data[5], data[9] >> 4, chrBank);
+    }
+    else
+    {
+        prgSize = data[4] * prgBank;
+        chrSize = data[5] * chrBank;
+    }
+
+    // Optional trainer precedes PRG
+    auto offset = header + ((data[6] & 0x04) ? trainer : 0);
+
+    if (prgSize == 0 || offset + prgSize + chrSize > size) {
+        throw std::runtime_error("Truncated cartridge image");
+    }
+
+    prg = data + offset;
+    chr = chrSize > 0 ? prg + prgSize : nullptr;
+}
+
+
+/*
+    Map image to bus
+*/
+void Rom::attach(Bus & bus) const
+{
+    if (format == Format::Raw)
+    {
+        auto size  = std::min(image.getSize(), bus.size());
+        auto pages = size >> 8;
+
+        // Whole pages are mapped in place, copy-on-write
+        if (pages > 0) {
+            bus.map(0x00, pages - 1, image.begin(), pages << 8);
+        }
+
+        // Partial last page is copied to internal RAM
+        std::copy(image.begin() + (pages << 8), image.begin() + size, bus.begin() + (pages << 8));
+        return;
+    }
+
+    // 2KB work RAM mirrored four times
+    bus.map(0x00, 0x1F, &*bus.begin(), 0x0800);
+
+    // Mapper bank switching is not emulated yet, banks
+    // are mapped like NROM and power-on state of most mappers
+    auto bank = std::min(prgSize, prgBank);
+
+    bus.map(0x80, 0xBF, prg, bank);
+    bus.map(0xC0, 0xFF, prg + prgSize - bank, bank);
+}
+
+
+/*
+    Start Cpu at image entry point
+*/
+void Rom::boot(Cpu & cpu) const
+{
+    // Cpu is created at $0400 already
+    if (format != Format::Raw) {
+        cpu.reset();
+    }
+}
+
+
+/*
+    Returns image format
+*/
+Rom::Format Rom::getFormat() const
+{
+    return format;
+}
+
+
+/*
+    Returns cartridge mapper number
+*/
+uint16_t Rom::getMapper() const
+{
+    return mapper;
+}
+
+
+/*
+    Returns cartridge PRG size in bytes
+*/
+std::size_t Rom::getPrgSize() const
+{
+    return prgSize;
+}
+
+
+/*
+    Returns cartridge CHR size in bytes
+*/
+std::size_t Rom::getChrSize() const
+{
+    return chrSize;
+}
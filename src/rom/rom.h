@@ -0,0 +1,120 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ROM_H
+#define ROM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapping.h"
+
+class Bus;
+class Cpu;
+
+//
+// ROM image
+//
+// Raw 64KB memory image or iNES / NES 2.0 cartridge. Image is
+// memory mapped and its banks are mapped to bus pages directly,
+// so ROM must outlive bus use
+//
+
+class Rom
+{
+public:
+
+    enum class Format : uint8_t
+    {
+        Raw,  // Plain memory image loaded from $0000
+        INes, // iNES cartridge
+        Nes2  // NES 2.0 cartridge
+    };
+
+private:
+
+    /*
+        Mapped image file
+    */
+    Mapping image;
+
+    Format format = Format::Raw;
+
+    /*
+        Cartridge PRG and CHR banks inside image
+    */
+    const uint8_t * prg = nullptr;
+    const uint8_t * chr = nullptr;
+
+    std::size_t prgSize = 0;
+    std::size_t chrSize = 0;
+
+    /*
+        Cartridge mapper number
+    */
+    uint16_t mapper = 0;
+
+    /*
+        Parse cartridge header if image has one
+    */
+    void parse();
+
+public:
+
+    /*
+        Map image file, throws if file is missing or truncated
+    */
+    Rom(const std::string & path);
+
+    /*
+        Map image to bus
+
+        Raw image is mapped as writable RAM from $0000. Cartridge
+        maps 2KB work RAM mirrored up to $1FFF, first PRG bank to
+        $8000 and last PRG bank to $C000
+    */
+    void attach(Bus & bus) const;
+
+    /*
+        Start Cpu at image entry point
+        Raw images start at $0400, cartridges at RESET vector
+    */
+    void boot(Cpu & cpu) const;
+
+    /*
+        Returns image format
+    */
+    Format getFormat() const;
+
+    /*
+        Returns cartridge mapper number
+    */
+    uint16_t getMapper() const;
+
+    /*
+        Returns cartridge PRG size in bytes
+    */
+    std::size_t getPrgSize() const;
+
+    /*
+        Returns cartridge CHR size in bytes
+    */
+    std::size_t getChrSize() const;
+};
+
+#endif
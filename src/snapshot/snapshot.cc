@@ -0,0 +1,257 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "snapshot.h"
+
+#include "cpu/cpu.h"
+#include "cpu/mem.h"
+
+/*
+    Closes file on scope exit
+*/
+struct Closer 
+{
+    void operator () (std::FILE * file) const {
+        std::fclose(file);
+    }
+};
+
+using File = std::unique_ptr<std::FILE, Closer>;
+
+
+/*
+    Capture CPU and its bus
+*/
+Snapshot::Snapshot(Cpu & cpu) : registers(read(cpu))
+{
+    cpu.mem.getBus().share(frames);
+}
+
+
+/*
+    Restore CPU and its bus
+*/
+void Snapshot::restore(Cpu & cpu) const
+{
+    write(cpu, registers);
+    cpu.mem.getBus().restore(frames);
+}
+
+
+/*
+    Write snapshot file
+*/
+void Snapshot::save(const std::string & path) const
+{
+    File file(std::fopen(path.c_str(), "wb"));
+
+    if (!file) {
+        throw std::runtime_error("Can't open snapshot file " + path);
+    }
+
+    if (!save(file.get())) {
+        throw std::runtime_error("Can't write snapshot file " + path);
+    }
+}
+
+
+/*
+    Write snapshot at file position
+*/
+bool Snapshot::save(std::FILE * file) const
+{
+    // Mirrored pages are written once
+    std::array<uint16_t, 256> index;
+    std::vector<const Bus::Frame *> distinct;
+
+    for (unsigned page = 0; page < frames.size(); page++)
+    {
+        index[page] = none;
+
+        if (!frames[page])
+            continue;
+
+        for (uint16_t other = 0; other < distinct.size() && index[page] == none; other++) 
+        {
+            if (distinct[other] == frames[page].get()) {
+                index[page] = other;
+            }
+        }
+
+        if (index[page] == none) 
+        {
+            index[page] = (uint16_t) distinct.size();
+            distinct.push_back(frames[page].get());
+        }
+    }
+
+    Header header;
+    header.frames = (uint32_t) distinct.size();
+
+    auto ok = std::fwrite(&header, sizeof(Header), 1, file) == 1
+           && std::fwrite(&registers, sizeof(Registers), 1, file) == 1
+           && std::fwrite(index.data(), sizeof(uint16_t), index.size(), file) == index.size();
+
+    for (auto frame : distinct) {
+        ok = ok && std::fwrite(frame -> data(), frame -> size(), 1, file) == 1;
+    }
+
+    return ok;
+}
+
+
+/*
+    Read snapshot file
+*/
+Snapshot Snapshot::load(const std::string & path)
+{
+    File file(std::fopen(path.c_str(), "rb"));
+
+    if (!file) {
+        throw std::runtime_error("Can't open snapshot file " + path);
+    }
+
+    Snapshot snapshot;
+
+    if (!load(file.get(), snapshot)) {
+        throw std::runtime_error("Invalid snapshot file " + path);
+    }
+
+    return snapshot;
+}
+
+
+/*
+    Read snapshot at file position
+*/
+bool Snapshot::load(std::FILE * file, Snapshot & snapshot)
+{
+    Header expected;
+    Header header;
+
+    std::array<uint16_t, 256> index;
+
+    auto ok = std::fread(&header, sizeof(Header), 1, file) == 1
+           && std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) == 0
+           && header.version == expected.version
+           && header.size == expected.size
+           && header.frames <= index.size()
+           && std::fread(&snapshot.registers, sizeof(Registers), 1, file) == 1
+           && std::fread(index.data(), sizeof(uint16_t), index.size(), file) == index.size();
+
+    std::vector<std::shared_ptr<Bus::Frame>> distinct;
+
+    for (uint32_t frame = 0; ok && frame < header.frames; frame++) 
+    {
+        distinct.push_back(std::make_shared<Bus::Frame>());
+        ok = std::fread(distinct.back() -> data(), distinct.back() -> size(), 1, file) == 1;
+    }
+
+    for (unsigned page = 0; ok && page < index.size(); page++)
+    {
+        if (index[page] == none)
+            continue;
+
+        ok = index[page] < distinct.size();
+
+        if (ok) {
+            snapshot.frames[page] = distinct[index[page]];
+        }
+    }
+
+    return ok;
+}
+
+
+/*
+    Returns true if registers and content of every page are equal
+*/
+bool Snapshot::matches(const Snapshot & other) const
+{
+    auto & l = registers;
+    auto & r = other.registers;
+
+    if (l.cycles != r.cycles || l.instructions != r.instructions || l.pc != r.pc ||
+        l.a != r.a || l.x != r.x || l.y != r.y || l.s != r.s || l.p != r.p)
+        return false;
+
+    for (unsigned page = 0; page < frames.size(); page++)
+    {
+        if (!frames[page] != !other.frames[page])
+            return false;
+
+        if (frames[page] && frames[page] != other.frames[page] && *frames[page] != *other.frames[page])
+            return false;
+    }
+
+    return true;
+}
+
+
+/*
+    Returns current registers of CPU
+*/
+Snapshot::Registers Snapshot::read(const Cpu & cpu)
+{
+    Registers registers {};
+
+    registers.cycles       = cpu.cycles;
+    registers.instructions = cpu.counter;
+    registers.pc = cpu.pc;
+    registers.a  = cpu.a;
+    registers.x  = cpu.x;
+    registers.y  = cpu.y;
+    registers.s  = cpu.s;
+    registers.p  = cpu.p;
+
+    return registers;
+}
+
+
+/*
+    Set registers of CPU, bus is not restored
+*/
+void Snapshot::write(Cpu & cpu, const Registers & registers)
+{
+    cpu.cycles  = registers.cycles;
+    cpu.counter = registers.instructions;
+    cpu.pc = registers.pc;
+    cpu.a  = registers.a;
+    cpu.x  = registers.x;
+    cpu.y  = registers.y;
+    cpu.s  = registers.s;
+    cpu.p  = registers.p;
+
+    // Break flag exists only on stack
+    cpu.p.setBreak(false);
+}
+
+
+/*
+    Returns captured registers
+*/
+const Snapshot::Registers & Snapshot::getRegisters() const
+{
+    return registers;
+}
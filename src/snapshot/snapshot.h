@@ -0,0 +1,144 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "bus/bus.h"
+
+class Cpu;
+
+//
+// Machine state snapshot
+//
+// CPU registers and bus RAM pages. Pages are shared with the bus
+// copy-on-write, so taking or restoring snapshot copies no memory;
+// each machine copies only pages it writes afterwards. Restore on
+// another machine with same ROM and devices forks it
+//
+
+class Snapshot
+{
+public:
+
+    //
+    // Snapshot file header
+    // Followed by registers, page to frame index table and frames
+    //
+
+    struct Header
+    {
+        char     magic[8] = { '6', '5', '0', '2', 'S', 'N', 'P', '\0' };
+        uint32_t version  = 1;
+        uint32_t size     = sizeof(Registers);
+
+        // Distinct frames in file
+        uint32_t frames = 0;
+    };
+
+    struct Registers
+    {
+        uint64_t cycles;
+        uint64_t instructions;
+
+        uint16_t pc;
+
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t s;
+
+        // Status as pushed on stack
+        uint8_t p;
+    };
+
+    /*
+        Page without frame in file
+    */
+    static const uint16_t none = 0xFFFF;
+
+private:
+
+    Registers registers {};
+
+    /*
+        Shared RAM pages, empty for ROM and device pages
+    */
+    Bus::Frames frames;
+
+public:
+
+    Snapshot() = default;
+
+    /*
+        Capture CPU and its bus
+    */
+    Snapshot(Cpu & cpu);
+
+    /*
+        Restore CPU and its bus
+    */
+    void restore(Cpu & cpu) const;
+
+    /*
+        Write snapshot file, throws on I/O error
+    */
+    void save(const std::string & path) const;
+
+    /*
+        Read snapshot file, throws on I/O or format error
+    */
+    static Snapshot load(const std::string & path);
+
+    /*
+        Write snapshot at position of open file, 
+        returns false on I/O error
+    */
+    bool save(std::FILE * file) const;
+
+    /*
+        Read snapshot at position of open file, 
+        returns false on I/O or format error
+    */
+    static bool load(std::FILE * file, Snapshot & snapshot);
+
+    /*
+        Returns true if registers and content of every page are equal
+    */
+    bool matches(const Snapshot & other) const;
+
+    /*
+        Returns captured registers
+    */
+    const Registers & getRegisters() const;
+
+    /*
+        Returns current registers of CPU, bus is not captured
+    */
+    static Registers read(const Cpu & cpu);
+
+    /*
+        Set registers of CPU, bus is not restored
+    */
+    static void write(Cpu & cpu, const Registers & registers);
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iterator>
+
+#include "stats.h"
+
+#include "fmt/core.h"
+#include "fmt/format.h"
+
+//
+// Scalar counters by export name
+//
+
+struct Metric
+{
+    const char * name;
+    const char * help;
+    uint64_t Stats::* counter;
+};
+
+static const Metric metrics[] =
+{
+    { "instructions",        "Instructions executed",                                           &Stats::instructions       },
+    { "cycles",              "CPU cycles executed",                                             &Stats::cycles             },
+    { "interrupts",          "IRQ and NMI taken",                                               &Stats::interrupts         },
+    { "pushes",              "Stack pushes",                                                    &Stats::pushes             },
+    { "pops",                "Stack pops",                                                      &Stats::pops               },
+    { "cache_lookups",       "Decode cache lookups",                                            &Stats::cacheLookups       },
+    { "cache_misses",        "Decode cache misses",                                             &Stats::cacheMisses        },
+    { "cache_invalidations", "Decode cache entries invalidated by write to one of their bytes", &Stats::cacheInvalidations },
+    { "block_lookups",       "Translated block lookups",                                        &Stats::blockLookups       },
+    { "block_hits",          "Translated block hits",                                           &Stats::blockHits          },
+    { "translations",        "Blocks translated",                                               &Stats::translations       },
+    { "block_drops",         "Translated blocks dropped by write to one of their bytes",        &Stats::blockDrops         },
+};
+
+
+/*
+    Add counters of other machine
+*/
+Stats & Stats::operator += (const Stats & other)
+{
+    for (auto & metric : metrics) {
+        this ->* metric.counter += other.*metric.counter;
+    }
+
+    for (std::size_t page = 0; page < deviceReads.size(); page++)
+    {
+        deviceReads[page]  += other.deviceReads[page];
+        deviceWrites[page] += other.deviceWrites[page];
+    }
+
+    return *this;
+}
+
+
+/*
+    Returns counters as JSON object
+    Device pages are keyed by hex page number, unused ones are left out
+*/
+std::string Stats::toJson() const
+{
+    fmt::memory_buffer out;
+    auto it = std::back_inserter(out);
+
+    fmt::format_to(it, "{{");
+
+    for (auto & metric : metrics) {
+        fmt::format_to(it, "\"{}\":{},", metric.name, this ->* metric.counter);
+    }
+
+    for (auto device : { &deviceReads, &deviceWrites })
+    {
+        fmt::format_to(it, "\"{}\":{{", device == &deviceReads ? "device_reads" : "device_writes");
+
+        auto separator = "";
+
+        for (std::size_t page = 0; page < device -> size(); page++)
+        {
+            if ((*device)[page] == 0)
+                continue;
+
+            fmt::format_to(it, "{}\"{:02X}\":{}", separator, page, (*device)[page]);
+            separator = ",";
+        }
+
+        fmt::format_to(it, "}}{}", device == &deviceReads ? "," : "");
+    }
+
+    fmt::format_to(it, "}}\n");
+
+    return fmt::to_string(out);
+}
+
+
+/*
+    Returns counters in Prometheus text format
+    Device pages are labeled by hex page number, unused ones are left out
+*/
+std::string Stats::toPrometheus() const
+{
+    fmt::memory_buffer out;
+    auto it = std::back_inserter(out);
+
+    for (auto & metric : metrics)
+    {
+        fmt::format_to(it, "# HELP mos6502_{}_total {}\n", metric.name, metric.help);
+        fmt::format_to(it, "# TYPE mos6502_{}_total counter\n", metric.name);
+        fmt::format_to(it, "mos6502_{}_total {}\n", metric.name, this ->* metric.counter);
+    }
+
+    for (auto device : { &deviceReads, &deviceWrites })
+    {
+        auto name = device == &deviceReads ? "reads" : "writes";
+
+        fmt::format_to(it, "# HELP mos6502_device_{}_total Device {} per page\n", name, name);
+        fmt::format_to(it, "# TYPE mos6502_device_{}_total counter\n", name);
+
+        for (std::size_t page = 0; page < device -> size(); page++)
+        {
+            if ((*device)[page] != 0) {
+                fmt::format_to(it, "mos6502_device_{}_total{{page=\"{:02X}\"}} {}\n", name, page, (*device)[page]);
+            }
+        }
+    }
+
+    return fmt::to_string(out);
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+//
+// Execution counters
+//
+// Collected from counters every Cpu component keeps for itself,
+// so hot paths only bump a member of object they already use.
+// Counters belong to single machine and are never shared between
+// threads, batch runner adds them up after workers are done
+//
+
+struct Stats
+{
+    uint64_t instructions = 0;
+    uint64_t cycles       = 0;
+
+    /*
+        IRQ and NMI taken
+    */
+    uint64_t interrupts = 0;
+
+    /*
+        Stack pushes and pops
+    */
+    uint64_t pushes = 0;
+    uint64_t pops   = 0;
+
+    /*
+        Decode cache lookups, misses and misses on entries
+        decoded before and invalidated by write to one of their bytes
+    */
+    uint64_t cacheLookups       = 0;
+    uint64_t cacheMisses        = 0;
+    uint64_t cacheInvalidations = 0;
+
+    /*
+        Translated block lookups, hits, translations and
+        blocks dropped after write to one of their bytes
+    */
+    uint64_t blockLookups = 0;
+    uint64_t blockHits    = 0;
+    uint64_t translations = 0;
+    uint64_t blockDrops   = 0;
+
+    /*
+        Device reads and writes per page
+        Host memory pages are not counted
+    */
+    std::array<uint64_t, 256> deviceReads  {};
+    std::array<uint64_t, 256> deviceWrites {};
+
+    /*
+        Add counters of other machine
+    */
+    Stats & operator += (const Stats & other);
+
+    /*
+        Returns counters as JSON object
+    */
+    std::string toJson() const;
+
+    /*
+        Returns counters in Prometheus text format
+    */
+    std::string toPrometheus() const;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iterator>
+
+#include "summary.h"
+
+#include "cpu/cpu.h"
+#include "bus/bus.h"
+
+//
+// Stop reasons by export name
+//
+
+static const char * const stops[] = { "done", "trap", "halt", "break", "error" };
+
+
+/*
+    Returns reason run loop of CPU stopped
+*/
+Summary::Stop Summary::reason(const Cpu & cpu)
+{
+    if (cpu.isBreak())
+        return Stop::Break;
+
+    if (cpu.isHalted())
+        return Stop::Halt;
+
+    if (cpu.isTrapped())
+        return Stop::Trap;
+
+    return Stop::Done;
+}
+
+
+/*
+    Read result of CPU and its bus
+*/
+Summary Summary::read(const Cpu & cpu, const Bus & bus, uint16_t from, uint16_t to, bool memory)
+{
+    Summary summary;
+
+    summary.registers = Snapshot::read(cpu);
+    summary.stop      = reason(cpu);
+
+    summary.from = from;
+    summary.to   = to;
+    summary.hash = 14695981039346656037ull;
+
+    // Reversed range is empty
+    for (uint32_t address = from; address <= to; address++) 
+    {
+        auto data = bus.peek((uint16_t) address);
+        summary.hash = (summary.hash ^ data) * 1099511628211ull;
+
+        if (memory) {
+            summary.memory.push_back(data);
+        }
+    }
+
+    return summary;
+}
+
+
+/*
+    Append result as one line JSON object
+*/
+void Summary::toJson(fmt::memory_buffer & out, const std::string & stats) const
+{
+    auto it = std::back_inserter(out);
+    auto & r = registers;
+
+    fmt::format_to(it, "{{\"stop\":\"{}\"", stops[(std::size_t) stop]);
+
+    if (stop == Stop::Error) 
+    {
+        fmt::format_to(it, ",\"error\":\"");
+
+        // Message is escaped for JSON string
+        for (auto c : error) 
+        {
+            if (c == '"' || c == '\\') {
+                fmt::format_to(it, "\\{}", c);
+            } else if ((unsigned char) c < 0x20) {
+                fmt::format_to(it, "\\u{:04x}", (unsigned) c);
+            } else {
+                out.push_back(c);
+            }
+        }
+
+        fmt::format_to(it, "\"}}\n");
+        return;
+    }
+
+    fmt::format_to(it, 
+        ",\"pc\":{},\"a\":{},\"x\":{},\"y\":{},\"s\":{},\"p\":{},\"instructions\":{},\"cycles\":{}",
+        r.pc, r.a, r.x, r.y, r.s, r.p, r.instructions, r.cycles);
+
+    fmt::format_to(it, ",\"from\":{},\"to\":{},\"hash\":\"{:016x}\"", from, to, hash);
+
+    if (!memory.empty()) 
+    {
+        fmt::format_to(it, ",\"memory\":\"");
+
+        for (auto data : memory) {
+            fmt::format_to(it, "{:02x}", data);
+        }
+
+        out.push_back('"');
+    }
+
+    // Counters object without its line break
+    if (!stats.empty()) {
+        fmt::format_to(it, ",\"stats\":{}", stats.substr(0, stats.find_last_not_of('\n') + 1));
+    }
+
+    fmt::format_to(it, "}}\n");
+}
+
+
+/*
+    Append binary record and memory bytes
+*/
+void Summary::toBinary(fmt::memory_buffer & out) const
+{
+    auto & r = registers;
+
+    Record record {};
+
+    record.cycles       = r.cycles;
+    record.instructions = r.instructions;
+    record.hash         = hash;
+    record.pc           = r.pc;
+    record.from         = from;
+    record.to           = to;
+    record.a            = r.a;
+    record.x            = r.x;
+    record.y            = r.y;
+    record.s            = r.s;
+    record.p            = r.p;
+    record.stop         = (uint8_t) stop;
+    record.memory       = (uint32_t) memory.size();
+
+    auto bytes = reinterpret_cast<const char *>(&record);
+
+    out.append(bytes, bytes + sizeof(record));
+    out.append(memory.data(), memory.data() + memory.size());
+}
+
+
+/*
+    Append binary stream header
+*/
+void Summary::header(fmt::memory_buffer & out)
+{
+    static const Header header;
+    auto bytes = reinterpret_cast<const char *>(&header);
+
+    out.append(bytes, bytes + sizeof(header));
+}
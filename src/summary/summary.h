@@ -0,0 +1,146 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "snapshot/snapshot.h"
+
+class Cpu;
+class Bus;
+
+//
+// Machine readable run result
+//
+// Final registers, reason the run stopped and FNV-1a hash of
+// memory range, optionally with the range itself. Records are
+// appended to caller's buffer, so any number of runs is written
+// out with one write
+//
+
+struct Summary
+{
+    enum class Stop : uint8_t
+    {
+        Done,  // Cycle budget exhausted
+        Trap,  // Jump or branch to itself
+        Halt,  // JAM
+        Break, // Breakpoint or watchpoint
+        Error  // Run failed, registers are not valid
+    };
+
+    //
+    // Binary result record
+    // Followed by memory bytes of range when they were read
+    //
+
+    struct Record
+    {
+        uint64_t cycles;
+        uint64_t instructions;
+        uint64_t hash;
+
+        uint16_t pc;
+
+        /*
+            Hashed memory range, inclusive
+        */
+        uint16_t from;
+        uint16_t to;
+
+        /*
+            Registers, status as pushed on stack (B flag set)
+        */
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t s;
+        uint8_t p;
+
+        uint8_t stop;
+
+        /*
+            Memory bytes following record, zero or range size
+        */
+        uint32_t memory;
+    };
+
+    //
+    // Binary result stream header, followed by records
+    //
+
+    struct Header
+    {
+        char     magic[8] = { '6', '5', '0', '2', 'R', 'E', 'S', '\0' };
+        uint32_t version  = 1;
+        uint32_t size     = sizeof(Record);
+    };
+
+    Snapshot::Registers registers {};
+    Stop stop = Stop::Done;
+
+    uint16_t from = 0x0000;
+    uint16_t to   = 0x0000;
+    uint64_t hash = 0;
+
+    /*
+        Memory range, empty unless it was requested
+    */
+    std::vector<uint8_t> memory;
+
+    /*
+        Error message of failed run
+    */
+    std::string error;
+
+    /*
+        Returns reason run loop of CPU stopped
+    */
+    static Stop reason(const Cpu & cpu);
+
+    /*
+        Read result of CPU and its bus, hash memory range
+        Memory is read without device side effects
+    */
+    static Summary read(const Cpu & cpu, const Bus & bus, uint16_t from, uint16_t to, bool memory = false);
+
+    /*
+        Append result as one line JSON object, counters
+        object is added as "stats" when not empty
+    */
+    void toJson(fmt::memory_buffer & out, const std::string & stats = "") const;
+
+    /*
+        Append binary record and memory bytes
+    */
+    void toBinary(fmt::memory_buffer & out) const;
+
+    /*
+        Append binary stream header
+    */
+    static void header(fmt::memory_buffer & out);
+};
+
+static_assert(sizeof(Summary::Record) == 40, "Record layout is part of the result format");
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <cstdint>
+
+//
+// Binary trace record
+// One executed instruction, registers after execution
+//
+
+struct Record
+{
+    /*
+        Total programm cycles after instruction
+    */
+    uint64_t cycle;
+
+    /*
+        Instruction address, operation code and operand bytes
+    */
+    uint16_t pc;
+    uint8_t  opcode;
+    uint8_t  args[2];
+
+    /*
+        Registers, status as pushed on stack (B flag set)
+    */
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t s;
+    uint8_t p;
+
+    /*
+        Explicit padding, always zero
+    */
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(Record) == 24, "Record layout is part of the trace file format");
+
+//
+// Binary trace file header
+// Followed by records until end of file
+//
+
+struct Header
+{
+    char     magic[8] = { '6', '5', '0', '2', 'T', 'R', 'C', '\0' };
+    uint32_t version  = 1;
+    uint32_t size     = sizeof(Record);
+};
+
+#endif
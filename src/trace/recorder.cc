@@ -0,0 +1,130 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "recorder.h"
+
+/*
+    Records written per file call
+*/
+static const size_t batch = 4096;
+
+
+/*
+    Open trace file and start writer thread
+*/
+Recorder::Recorder(const std::string & path, size_t capacity) : ring(capacity)
+{
+    file = std::fopen(path.c_str(), "wb");
+
+    if (file == nullptr) {
+        throw std::runtime_error("Can't open trace file " + path);
+    }
+
+    Header header;
+    std::fwrite(&header, sizeof(Header), 1, file);
+
+    sink = [this](const Record * records, std::size_t count) {
+        std::fwrite(records, sizeof(Record), count, this -> file);
+    };
+
+    writer = std::thread(&Recorder::consume, this);
+}
+
+
+/*
+    Start writer thread passing records to sink
+*/
+Recorder::Recorder(Sink sink, size_t capacity) : ring(capacity), sink(std::move(sink))
+{
+    writer = std::thread(&Recorder::consume, this);
+}
+
+
+/*
+    Drain ring, stop writer thread and close file
+*/
+Recorder::~Recorder()
+{
+    running.store(false, std::memory_order_release);
+    writer.join();
+
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+
+/*
+    Queue record, returns false if it was dropped
+*/
+bool Recorder::push(const Record & record)
+{
+    if (ring.push(record))
+        return true;
+
+    dropped++;
+    return false;
+}
+
+
+/*
+    Returns number of dropped records
+*/
+uint64_t Recorder::getDropped() const
+{
+    return dropped;
+}
+
+
+/*
+    Writer thread loop
+    Stop flag is read before draining, so records pushed
+    before destruction are always written
+*/
+void Recorder::consume()
+{
+    std::vector<Record> records;
+    records.reserve(batch);
+
+    Record record;
+
+    while (true)
+    {
+        bool stop = !running.load(std::memory_order_acquire);
+
+        while (records.size() < batch && ring.pop(record)) {
+            records.push_back(record);
+        }
+
+        if (!records.empty())
+        {
+            sink(records.data(), records.size());
+            records.clear();
+
+            continue;
+        }
+
+        if (stop)
+            break;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "record.h"
+#include "ring.h"
+
+//
+// Binary trace recorder
+//
+// Emulation thread pushes records into lock-free ring,
+// writer thread drains it to file or sink. Records are 
+// dropped and counted when ring is full, so producer 
+// never blocks
+//
+
+class Recorder
+{
+public:
+
+    /*
+        Called on writer thread with batch of records
+    */
+    using Sink = std::function<void(const Record * records, std::size_t count)>;
+
+private:
+
+    Ring<Record> ring;
+
+    std::FILE * file = nullptr;
+
+    Sink sink;
+
+    /*
+        Writer thread and its stop flag
+    */
+    std::thread writer;
+    std::atomic<bool> running { true };
+
+    /*
+        Records lost because ring was full
+        Updated by producer only
+    */
+    uint64_t dropped = 0;
+
+    /*
+        Writer thread loop
+    */
+    void consume();
+
+public:
+
+    /*
+        Open trace file and start writer thread
+    */
+    Recorder(const std::string & path, size_t capacity = 1 << 20);
+
+    /*
+        Start writer thread passing records to sink
+    */
+    Recorder(Sink sink, size_t capacity = 1 << 20);
+
+    /*
+        Drain ring, stop writer thread and close file
+    */
+    ~Recorder();
+
+    Recorder(const Recorder &) = delete;
+    Recorder & operator = (const Recorder &) = delete;
+
+    /*
+        Queue record, returns false if it was dropped
+    */
+    bool push(const Record & record);
+
+    /*
+        Returns number of dropped records
+    */
+    uint64_t getDropped() const;
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+//
+// Lock-free single producer, single consumer ring buffer
+// Capacity is rounded up to power of two
+//
+
+template <typename T>
+class Ring
+{
+private:
+
+    std::unique_ptr<T[]> items;
+
+    size_t mask;
+
+    /*
+        Position padded to cache line, so producer and
+        consumer do not invalidate each other's line
+    */
+    struct Position
+    {
+        std::atomic<size_t> value { 0 };
+        char padding[64 - sizeof(std::atomic<size_t>)];
+    };
+
+    Position head;
+    Position tail;
+
+public:
+
+    explicit Ring(size_t capacity)
+    {
+        size_t size = 1;
+
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        items = std::make_unique<T[]>(size);
+        mask  = size - 1;
+    }
+
+    /*
+        Producer side
+        Returns false and drops item if ring is full
+    */
+    bool push(const T & item)
+    {
+        auto h = head.value.load(std::memory_order_relaxed);
+
+        if (h - tail.value.load(std::memory_order_acquire) > mask)
+            return false;
+
+        items[h & mask] = item;
+        head.value.store(h + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /*
+        Consumer side
+        Returns false if ring is empty
+    */
+    bool pop(T & item)
+    {
+        auto t = tail.value.load(std::memory_order_relaxed);
+
+        if (t == head.value.load(std::memory_order_acquire))
+            return false;
+
+        item = items[t & mask];
+        tail.value.store(t + 1, std::memory_order_release);
+
+        return true;
+    }
+};
+
+#endif
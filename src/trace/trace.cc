@@ -0,0 +1,73 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+
+/*
+    Trace every instruction
+*/
+Trace::Trace()
+{
+    opcodes.set();
+}
+
+
+/*
+    Trace only instructions with counter in [from, to]
+*/
+void Trace::setWindow(uint64_t from, uint64_t to)
+{
+    this -> from = from;
+    this -> to   = to;
+}
+
+
+/*
+    Trace only instructions with program counter in [lo, hi]
+*/
+void Trace::setRange(uint16_t lo, uint16_t hi)
+{
+    this -> lo = lo;
+    this -> hi = hi;
+}
+
+
+/*
+    Trace only listed operation codes
+*/
+void Trace::addOpcode(uint8_t opcode)
+{
+    if (!filtered)
+    {
+        opcodes.reset();
+        filtered = true;
+    }
+
+    opcodes.set(opcode);
+}
+
+
+/*
+    Returns true if instruction should be traced
+*/
+bool Trace::accept(uint64_t counter, uint16_t pc, uint8_t opcode) const
+{
+    return counter >= from && counter <= to 
+        && pc >= lo && pc <= hi 
+        && opcodes.test(opcode);
+}
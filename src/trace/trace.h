@@ -0,0 +1,85 @@
+/*
+ * This file is part of the NES-6502 distribution (https://github.com/temaweb/NES-6502).
+ * Copyright (c) 2021 Artem Okonechnikov.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <bitset>
+#include <cstdint>
+#include <limits>
+
+//
+// Trace filter
+// Selects instructions passed to disassembler
+//
+
+class Trace
+{
+private:
+
+    /*
+        Instruction counter window [from, to]
+    */
+    uint64_t from = 0;
+    uint64_t to   = std::numeric_limits<uint64_t>::max();
+
+    /*
+        Program counter range [lo, hi]
+    */
+    uint16_t lo = 0x0000;
+    uint16_t hi = 0xFFFF;
+
+    /*
+        Traced operation codes, all by default
+    */
+    std::bitset<256> opcodes;
+
+    /*
+        Set when opcode list was given
+    */
+    bool filtered = false;
+
+public:
+
+    /*
+        Trace every instruction
+    */
+    Trace();
+
+    /*
+        Trace only instructions with counter in [from, to]
+    */
+    void setWindow(uint64_t from, uint64_t to);
+
+    /*
+        Trace only instructions with program counter in [lo, hi]
+    */
+    void setRange(uint16_t lo, uint16_t hi);
+
+    /*
+        Trace only listed operation codes
+        First call drops default "all opcodes" selection
+    */
+    void addOpcode(uint8_t opcode);
+
+    /*
+        Returns true if instruction should be traced
+    */
+    bool accept(uint64_t counter, uint16_t pc, uint8_t opcode) const;
+};
+
+#endif